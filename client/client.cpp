@@ -4,18 +4,92 @@
 #include <iostream>
 #include <string>
 #include <sstream>
+#include <cstring>
 #include <iomanip>
 #include <vector>
+#include <map>
+#include <mutex>
 
 using json = nlohmann::json;
 
-std::string fetch_all_cars(const std::string& host, int port) {
-    std::string request = 
-        "GET /cars HTTP/1.1\r\n"
+namespace {
+
+// Последний полученный ответ 200 и его ETag для каждого host:port + путь
+struct CachedResponse {
+    std::string etag;
+    std::string response;
+};
+
+std::map<std::string, CachedResponse> response_cache;
+std::mutex response_cache_mutex;
+
+// Условный GET: сервер отвечает 304 без тела, если данные не менялись,
+// и тогда возвращается сохранённый ранее ответ
+std::string fetch_revalidated(const std::string& path, const std::string& host, int port) {
+    std::lock_guard<std::mutex> lock(response_cache_mutex);
+    CachedResponse& cached = response_cache[host + ":" + std::to_string(port) + path];
+
+    std::string request =
+        "GET " + path + " HTTP/1.1\r\n"
         "Host: " + host + "\r\n"
-        "Connection: close\r\n"
+        "Connection: keep-alive\r\n";
+    if (!cached.etag.empty()) {
+        request += "If-None-Match: " + cached.etag + "\r\n";
+    }
+    request += "\r\n";
+
+    std::string response = send_http_request(host, port, request);
+    if (response.compare(0, 12, "HTTP/1.1 304") == 0 && !cached.response.empty()) {
+        return cached.response;
+    }
+    if (response.compare(0, 12, "HTTP/1.1 200") == 0) {
+        cached.etag = get_header_value(response.substr(0, response.find("\r\n\r\n")), "ETag");
+        cached.response = response;
+    }
+    return response;
+}
+
+// Размер страницы результатов поиска
+constexpr int SEARCH_PAGE_SIZE = 20;
+
+// Последний поисковый запрос: следующие страницы запрашиваются по курсору
+struct SearchRequest {
+    bool post = false;
+    std::string target; // для GET — путь с параметрами
+    json body;          // для POST — тело запроса
+    std::string host;
+    int port = 0;
+};
+
+SearchRequest last_search;
+
+std::string fetch_search_page(const std::string& cursor) {
+    const SearchRequest& search = last_search;
+    if (search.post) {
+        json request_body = search.body;
+        request_body["cursor"] = cursor;
+        std::string body = request_body.dump();
+        std::string request =
+            "POST " + search.target + " HTTP/1.1\r\n"
+            "Host: " + search.host + "\r\n"
+            "Content-Type: application/json\r\n"
+            "Content-Length: " + std::to_string(body.size()) + "\r\n"
+            "Connection: keep-alive\r\n"
+            "\r\n" + body;
+        return send_http_request(search.host, search.port, request);
+    }
+    std::string request =
+        "GET " + search.target + "&cursor=" + cursor + " HTTP/1.1\r\n"
+        "Host: " + search.host + "\r\n"
+        "Connection: keep-alive\r\n"
         "\r\n";
-    return send_http_request(host, port, request);
+    return send_http_request(search.host, search.port, request);
+}
+
+} // namespace
+
+std::string fetch_all_cars(const std::string& host, int port) {
+    return fetch_revalidated("/cars", host, port);
 }
 
 std::string fetch_cars_by_specs(const std::string& specs, const std::string& host, int port) {
@@ -27,34 +101,29 @@ std::string fetch_cars_by_specs(const std::string& specs, const std::string& hos
     try {
         std::cout << "Поиск параметров: " << specs << std::endl;
 
-        // Парсим параметры и формируем JSON фильтры с поддержкой >= и <=
+        // Парсим параметры и формируем JSON фильтры с операторами сравнения
         json filters = json::object();
         std::istringstream iss(specs);
         std::string pair;
 
+        // Двухсимвольные операторы проверяются раньше односимвольных
+        static const std::pair<const char*, const char*> OPERATORS[] = {
+            {">=", "$gte"}, {"<=", "$lte"}, {"!=", "$ne"}, {">", "$gt"}, {"<", "$lt"}, {"=", "$eq"}
+        };
+
         while (std::getline(iss, pair, ',')) {
-            // Ищем операторы >= и <=
             std::string field, op, value_str;
 
-            if (pair.find(">=") != std::string::npos) {
-                size_t op_pos = pair.find(">=");
-                field = pair.substr(0, op_pos);
-                op = "$gte";
-                value_str = pair.substr(op_pos + 2);
-            }
-            else if (pair.find("<=") != std::string::npos) {
-                size_t op_pos = pair.find("<=");
-                field = pair.substr(0, op_pos);
-                op = "$lte";
-                value_str = pair.substr(op_pos + 2);
-            }
-            else if (pair.find('=') != std::string::npos) {
-                size_t op_pos = pair.find('=');
-                field = pair.substr(0, op_pos);
-                op = "$eq";
-                value_str = pair.substr(op_pos + 1);
+            for (const auto& [symbol, name] : OPERATORS) {
+                size_t op_pos = pair.find(symbol);
+                if (op_pos != std::string::npos) {
+                    field = pair.substr(0, op_pos);
+                    op = name;
+                    value_str = pair.substr(op_pos + std::strlen(symbol));
+                    break;
+                }
             }
-            else {
+            if (op.empty()) {
                 // Пропускаем некорректные параметры
                 continue;
             }
@@ -86,8 +155,8 @@ std::string fetch_cars_by_specs(const std::string& specs, const std::string& hos
                 filters[field] = value;
             }
             else {
-                // Иначе создаем объект с оператором
-                filters[field] = json::object();
+                // Иначе добавляем оператор к условиям поля (year>=2010,year<=2020)
+                if (!filters[field].is_object()) filters[field] = json::object();
                 filters[field][op] = value;
             }
         }
@@ -95,7 +164,9 @@ std::string fetch_cars_by_specs(const std::string& specs, const std::string& hos
         // Формируем JSON тело запроса
         json request_body;
         request_body["filters"] = filters;
+        request_body["limit"] = SEARCH_PAGE_SIZE;
         std::string body = request_body.dump();
+        last_search = {true, "/search", request_body, host, port};
 
         std::cout << "Тело запроса: " << body << std::endl;
 
@@ -105,7 +176,7 @@ std::string fetch_cars_by_specs(const std::string& specs, const std::string& hos
             "Host: " + host + "\r\n"
             "Content-Type: application/json\r\n"
             "Content-Length: " + std::to_string(body.size()) + "\r\n"
-            "Connection: close\r\n"
+            "Connection: keep-alive\r\n"
             "\r\n" + body;
 
         std::cout << "Отправка POST-запроса..." << std::endl;
@@ -118,30 +189,28 @@ std::string fetch_cars_by_specs(const std::string& specs, const std::string& hos
 }
 
 std::string fetch_cars_by_brand_model(const std::string& brand, const std::string& model, const std::string& host, int port) {
-    std::string query = "brand=" + brand;
-    if (!model.empty()) query += "&model=" + model;
+    // Пробелы и кириллица в названиях передаются в процентной кодировке
+    std::string query = "brand=" + url_encode(brand);
+    if (!model.empty()) query += "&model=" + url_encode(model);
+    query += "&limit=" + std::to_string(SEARCH_PAGE_SIZE);
+    last_search = {false, "/search?" + query, json(), host, port};
     std::string request = 
         "GET /search?" + query + " HTTP/1.1\r\n"
         "Host: " + host + "\r\n"
-        "Connection: close\r\n"
+        "Connection: keep-alive\r\n"
         "\r\n";
     return send_http_request(host, port, request);
 }
 
 std::string fetch_delivery_cities(const std::string& host, int port) {
-    std::string request = 
-        "GET /cities HTTP/1.1\r\n"
-        "Host: " + host + "\r\n"
-        "Connection: close\r\n"
-        "\r\n";
-    return send_http_request(host, port, request);
+    return fetch_revalidated("/cities", host, port);
 }
 
 std::string fetch_required_documents(const std::string& host, int port) {
     std::string request = 
         "GET /documents HTTP/1.1\r\n"
         "Host: " + host + "\r\n"
-        "Connection: close\r\n"
+        "Connection: keep-alive\r\n"
         "\r\n";
     return send_http_request(host, port, request);
 }
@@ -150,7 +219,7 @@ std::string fetch_delivery_process(const std::string& host, int port) {
     std::string request = 
         "GET /delivery HTTP/1.1\r\n"
         "Host: " + host + "\r\n"
-        "Connection: close\r\n"
+        "Connection: keep-alive\r\n"
         "\r\n";
     return send_http_request(host, port, request);
 }
@@ -164,7 +233,7 @@ std::string fetch_admin_login(const std::string& username, const std::string& pa
             "Host: " + host + "\r\n"
             "Content-Type: application/json\r\n"
             "Content-Length: " + std::to_string(body.size()) + "\r\n"
-            "Connection: close\r\n"
+            "Connection: keep-alive\r\n"
             "\r\n" + body;
         return send_http_request(host, port, request);
     } catch (...) {
@@ -182,7 +251,7 @@ std::string fetch_delivery_calculation(int car_id, int city_id, const std::strin
             "Host: " + host + "\r\n"
             "Content-Type: application/json\r\n"
             "Content-Length: " + std::to_string(body.size()) + "\r\n"
-            "Connection: close\r\n"
+            "Connection: keep-alive\r\n"
             "\r\n" + body;
 
         return send_http_request(host, port, request);
@@ -301,6 +370,30 @@ void print_search_results(const json& results) {
         if (n > 0 && results.contains("results")) print_car_table(results["results"]);
         else if (n == 0) std::cout << "Ни одно транспортное средство не соответствует указанным критериям.\n";
     }
+
+    // Следующие страницы запрашиваются только по просьбе пользователя
+    size_t shown = results.contains("results") ? results["results"].size() : 0;
+    json page = results;
+    while (page.contains("next_cursor")) {
+        std::cout << "Показано " << shown << " из " << results.value("found", 0)
+                  << ". Показать следующие? (y/n): ";
+        char more;
+        std::cin >> more;
+        if (more != 'y' && more != 'Y') break;
+        try {
+            page = json::parse(extract_json_from_response(fetch_search_page(page["next_cursor"])));
+        }
+        catch (const json::exception& e) {
+            std::cerr << "JSON parse error: " << e.what() << '\n';
+            break;
+        }
+        if (page.contains("error")) {
+            std::cout << "Ошибка: " << page["error"] << '\n';
+            break;
+        }
+        print_car_table(page["results"]);
+        shown += page["results"].size();
+    }
 }
 
 void print_admin_login_result(const json& result) {
@@ -447,7 +540,7 @@ std::string fetch_admin_cars(const std::string& host, int port) {
     std::string request =
         "GET /admin/cars HTTP/1.1\r\n"
         "Host: " + host + "\r\n"
-        "Connection: close\r\n"
+        "Connection: keep-alive\r\n"
         "\r\n";
     return send_http_request(host, port, request);
 }
@@ -456,7 +549,7 @@ std::string fetch_admin_cities(const std::string& host, int port) {
     std::string request =
         "GET /admin/cities HTTP/1.1\r\n"
         "Host: " + host + "\r\n"
-        "Connection: close\r\n"
+        "Connection: keep-alive\r\n"
         "\r\n";
     return send_http_request(host, port, request);
 }
@@ -465,7 +558,7 @@ std::string fetch_admin_documents(const std::string& host, int port) {
     std::string request =
         "GET /admin/documents HTTP/1.1\r\n"
         "Host: " + host + "\r\n"
-        "Connection: close\r\n"
+        "Connection: keep-alive\r\n"
         "\r\n";
     return send_http_request(host, port, request);
 }
@@ -484,7 +577,7 @@ std::string add_admin_car(const std::string& brand, const std::string& model, in
             "Host: " + host + "\r\n"
             "Content-Type: application/json\r\n"
             "Content-Length: " + std::to_string(body.size()) + "\r\n"
-            "Connection: close\r\n"
+            "Connection: keep-alive\r\n"
             "\r\n" + body;
         return send_http_request(host, port, request);
     } catch (...) {
@@ -505,7 +598,7 @@ std::string add_admin_city(const std::string& name, int delivery_days, int deliv
             "Host: " + host + "\r\n"
             "Content-Type: application/json\r\n"
             "Content-Length: " + std::to_string(body.size()) + "\r\n"
-            "Connection: close\r\n"
+            "Connection: keep-alive\r\n"
             "\r\n" + body;
         return send_http_request(host, port, request);
     } catch (...) {
@@ -525,7 +618,7 @@ std::string add_admin_document(const std::string& category, const std::string& n
             "Host: " + host + "\r\n"
             "Content-Type: application/json\r\n"
             "Content-Length: " + std::to_string(body.size()) + "\r\n"
-            "Connection: close\r\n"
+            "Connection: keep-alive\r\n"
             "\r\n" + body;
         return send_http_request(host, port, request);
     }
@@ -548,7 +641,7 @@ std::string update_admin_car(int car_id, const std::string& brand, const std::st
             "Host: " + host + "\r\n"
             "Content-Type: application/json\r\n"
             "Content-Length: " + std::to_string(body.size()) + "\r\n"
-            "Connection: close\r\n"
+            "Connection: keep-alive\r\n"
             "\r\n" + body;
         return send_http_request(host, port, request);
     } catch (...) {
@@ -569,7 +662,7 @@ std::string update_admin_city(int city_id, const std::string& name, int delivery
             "Host: " + host + "\r\n"
             "Content-Type: application/json\r\n"
             "Content-Length: " + std::to_string(body.size()) + "\r\n"
-            "Connection: close\r\n"
+            "Connection: keep-alive\r\n"
             "\r\n" + body;
         return send_http_request(host, port, request);
     } catch (...) {
@@ -582,7 +675,7 @@ std::string delete_admin_car(int car_id, const std::string& host, int port) {
         std::string request =
             "DELETE /admin/cars/" + std::to_string(car_id) + " HTTP/1.1\r\n"
             "Host: " + host + "\r\n"
-            "Connection: close\r\n"
+            "Connection: keep-alive\r\n"
             "\r\n";
         return send_http_request(host, port, request);
     } catch (...) {
@@ -595,7 +688,7 @@ std::string delete_admin_city(int city_id, const std::string& host, int port) {
         std::string request =
             "DELETE /admin/cities/" + std::to_string(city_id) + " HTTP/1.1\r\n"
             "Host: " + host + "\r\n"
-            "Connection: close\r\n"
+            "Connection: keep-alive\r\n"
             "\r\n";
         return send_http_request(host, port, request);
     } catch (...) {
@@ -615,7 +708,7 @@ std::string delete_admin_document(const std::string& category, const std::string
             "Host: " + host + "\r\n"
             "Content-Type: application/json\r\n"
             "Content-Length: " + std::to_string(body.size()) + "\r\n"
-            "Connection: close\r\n"
+            "Connection: keep-alive\r\n"
             "\r\n" + body;
         return send_http_request(host, port, request);
     } catch (...) {
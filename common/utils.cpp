@@ -3,6 +3,9 @@
 #include <sstream>
 #include <boost/asio.hpp>
 #include <iostream>
+#include <cctype>
+#include <memory>
+#include <mutex>
 
 std::string read_file(const std::string& path) {
     std::ifstream file(path);
@@ -15,6 +18,33 @@ std::string read_file(const std::string& path) {
     );
 }
 
+std::string get_header_value(const std::string& headers, const std::string& name) {
+    size_t line_start = headers.find('\n');
+    while (line_start != std::string::npos && line_start + 1 < headers.size()) {
+        line_start += 1;
+        size_t line_end = headers.find('\n', line_start);
+        std::string line = headers.substr(line_start, line_end == std::string::npos ? std::string::npos : line_end - line_start);
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty()) break; // конец заголовков
+
+        size_t colon = line.find(':');
+        if (colon == name.size()) {
+            bool same = true;
+            for (size_t i = 0; i < colon && same; ++i) {
+                same = std::tolower(static_cast<unsigned char>(line[i])) ==
+                       std::tolower(static_cast<unsigned char>(name[i]));
+            }
+            if (same) {
+                size_t begin = line.find_first_not_of(" \t", colon + 1);
+                size_t end = line.find_last_not_of(" \t");
+                return begin == std::string::npos ? "" : line.substr(begin, end - begin + 1);
+            }
+        }
+        line_start = line_end;
+    }
+    return "";
+}
+
 std::string extract_json_from_response(const std::string& http_response) {
     size_t body_start = http_response.find("\r\n\r\n");
     if (body_start != std::string::npos) {
@@ -27,26 +57,163 @@ std::string extract_json_from_response(const std::string& http_response) {
     return http_response;
 }
 
+namespace {
+
+using boost::asio::ip::tcp;
+
+// Постоянное соединение с сервером (HTTP/1.1 keep-alive), переиспользуется
+// между вызовами send_http_request для того же host:port
+struct PersistentConnection {
+    boost::asio::io_context io_context;
+    std::unique_ptr<tcp::socket> socket;
+    std::string host;
+    int port = 0;
+    std::mutex mutex;
+};
+
+PersistentConnection& connection() {
+    static PersistentConnection conn;
+    return conn;
+}
+
+bool iequals(const std::string& a, const std::string& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (std::tolower(static_cast<unsigned char>(a[i])) != std::tolower(static_cast<unsigned char>(b[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Один обмен запрос-ответ по открытому соединению. Возвращает false, если
+// сервер закрыл соединение, не прислав ни байта ответа (можно повторить).
+bool exchange(tcp::socket& socket, const std::string& request, std::string& response, bool& keep_alive) {
+    boost::system::error_code ec;
+    boost::asio::write(socket, boost::asio::buffer(request), ec);
+    if (ec) return false;
+
+    boost::asio::streambuf response_buffer;
+    size_t header_size = boost::asio::read_until(socket, response_buffer, "\r\n\r\n", ec);
+    if (ec && response_buffer.size() == 0) return false;
+
+    response.assign(
+        boost::asio::buffers_begin(response_buffer.data()),
+        boost::asio::buffers_end(response_buffer.data()));
+    if (ec) {
+        keep_alive = false;
+        return true;
+    }
+
+    std::string headers = response.substr(0, header_size);
+    std::string content_length = get_header_value(headers, "Content-Length");
+    keep_alive = !iequals(get_header_value(headers, "Connection"), "close");
+
+    // У ответа 304 Not Modified тела нет независимо от заголовков
+    bool not_modified = headers.compare(0, 5, "HTTP/") == 0 && headers.compare(8, 4, " 304") == 0;
+
+    if (not_modified) {
+        return true;
+    }
+
+    if (content_length.empty()) {
+        // Без Content-Length тело заканчивается закрытием соединения
+        while (boost::asio::read(socket, response_buffer, boost::asio::transfer_at_least(1), ec));
+        keep_alive = false;
+    }
+    else {
+        size_t body_size = std::stoul(content_length);
+        size_t have = response_buffer.size() - header_size;
+        if (have < body_size) {
+            boost::asio::read(socket, response_buffer, boost::asio::transfer_exactly(body_size - have), ec);
+            if (ec) keep_alive = false;
+        }
+    }
+
+    response.assign(
+        boost::asio::buffers_begin(response_buffer.data()),
+        boost::asio::buffers_end(response_buffer.data()));
+    return true;
+}
+
+} // namespace
+
 std::string send_http_request(const std::string& host, int port, const std::string& request) {
     try {
-        using boost::asio::ip::tcp;
-        boost::asio::io_context io_context;
-        tcp::resolver resolver(io_context);
-        tcp::socket socket(io_context);
-        auto endpoint = resolver.resolve(host, std::to_string(port));
-        boost::asio::connect(socket, endpoint);
-        boost::asio::write(socket, boost::asio::buffer(request));
-
-        boost::asio::streambuf response_buffer;
-        boost::system::error_code ec;
-        while (boost::asio::read(socket, response_buffer, boost::asio::transfer_at_least(1), ec));
-        
-        return std::string(
-            std::istreambuf_iterator<char>(&response_buffer),
-            std::istreambuf_iterator<char>()
-        );
+        PersistentConnection& conn = connection();
+        std::lock_guard<std::mutex> lock(conn.mutex);
+
+        if (conn.socket && (conn.host != host || conn.port != port)) {
+            conn.socket.reset();
+        }
+
+        // Повторяем один раз на новом соединении, если сервер успел закрыть
+        // простаивающее соединение до получения запроса
+        for (int attempt = 0; attempt < 2; ++attempt) {
+            bool reused = static_cast<bool>(conn.socket);
+            if (!reused) {
+                tcp::resolver resolver(conn.io_context);
+                auto endpoint = resolver.resolve(host, std::to_string(port));
+                conn.socket = std::make_unique<tcp::socket>(conn.io_context);
+                boost::asio::connect(*conn.socket, endpoint);
+                conn.host = host;
+                conn.port = port;
+            }
+
+            std::string response;
+            bool keep_alive = false;
+            if (exchange(*conn.socket, request, response, keep_alive)) {
+                if (!keep_alive) conn.socket.reset();
+                return response;
+            }
+            conn.socket.reset();
+            if (!reused) break;
+        }
+        return R"({"error": "Connection failed", "message": "Connection closed by server"})";
     } catch (const std::exception& e) {
+        connection().socket.reset();
         // Возвращаем JSON с ошибкой вместо падения
         return R"({"error": "Connection failed", "message": ")" + std::string(e.what()) + "\"}";
     }
-}
\ No newline at end of file
+}
+
+std::string url_encode(const std::string& value) {
+    static const char HEX[] = "0123456789ABCDEF";
+    std::string encoded;
+    encoded.reserve(value.size());
+    for (unsigned char c : value) {
+        if (std::isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~') {
+            encoded += static_cast<char>(c);
+        }
+        else {
+            encoded += '%';
+            encoded += HEX[c >> 4];
+            encoded += HEX[c & 0xF];
+        }
+    }
+    return encoded;
+}
+
+std::string url_decode(const std::string& value) {
+    auto hex = [](char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    };
+    std::string decoded;
+    decoded.reserve(value.size());
+    for (size_t i = 0; i < value.size(); ++i) {
+        if (value[i] == '+') {
+            decoded += ' ';
+        }
+        else if (value[i] == '%' && i + 2 < value.size() && hex(value[i + 1]) >= 0 && hex(value[i + 2]) >= 0) {
+            decoded += static_cast<char>(hex(value[i + 1]) * 16 + hex(value[i + 2]));
+            i += 2;
+        }
+        else {
+            decoded += value[i];
+        }
+    }
+    return decoded;
+}
@@ -7,5 +7,13 @@ std::string read_file(const std::string& path);
 // Отправка HTTP-запроса с обработкой ошибок
 std::string send_http_request(const std::string& host, int port, const std::string& request);
 
+// Значение HTTP-заголовка (имя без учёта регистра), пустая строка если его нет
+std::string get_header_value(const std::string& headers, const std::string& name);
+
 // Извлечение тела JSON из HTTP-ответа
-std::string extract_json_from_response(const std::string& http_response);
\ No newline at end of file
+std::string extract_json_from_response(const std::string& http_response);
+// Кодирование значения для строки запроса (RFC 3986: всё, кроме A-Z a-z 0-9 - _ . ~, как %XX)
+std::string url_encode(const std::string& value);
+
+// Декодирование %XX и '+' (пробел) из строки запроса; неверные %-последовательности остаются как есть
+std::string url_decode(const std::string& value);
@@ -0,0 +1,49 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Плотная битовая карта выборки: бит i — строка i хранилища
+class Bitmap {
+public:
+    explicit Bitmap(size_t size = 0) : size_(size), words_((size + 63) / 64) {}
+
+    size_t size() const { return size_; }
+    size_t word_count() const { return words_.size(); }
+    uint64_t* data() { return words_.data(); }
+    const uint64_t* data() const { return words_.data(); }
+
+    void set(size_t i) { words_[i / 64] |= uint64_t(1) << (i % 64); }
+    bool test(size_t i) const { return (words_[i / 64] >> (i % 64)) & 1; }
+
+    Bitmap& operator&=(const Bitmap& other) {
+        for (size_t i = 0; i < words_.size(); ++i) words_[i] &= other.words_[i];
+        return *this;
+    }
+    Bitmap& operator|=(const Bitmap& other) {
+        for (size_t i = 0; i < words_.size(); ++i) words_[i] |= other.words_[i];
+        return *this;
+    }
+
+    size_t count() const {
+        size_t total = 0;
+        for (uint64_t word : words_) total += static_cast<size_t>(__builtin_popcountll(word));
+        return total;
+    }
+
+    // Обход установленных битов по возрастанию
+    template<class F>
+    void for_each(F&& f) const {
+        for (size_t w = 0; w < words_.size(); ++w) {
+            uint64_t word = words_[w];
+            while (word) {
+                f(static_cast<uint32_t>(w * 64 + static_cast<size_t>(__builtin_ctzll(word))));
+                word &= word - 1;
+            }
+        }
+    }
+
+private:
+    size_t size_;
+    std::vector<uint64_t> words_;
+};
@@ -0,0 +1,124 @@
+#include "car_facets.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <type_traits>
+
+namespace {
+
+// Ширина корзины гистограммы по числовым столбцам CarStore::NUMERIC_FIELDS
+constexpr double BUCKET_WIDTH[CarIndex::NUMERIC_COLUMNS] = {
+    1,    // year
+    5000, // price_usd
+    50,   // horsepower
+    0.5   // engine_volume
+};
+
+// Больше корзин интерфейсу не нужно; при широком разбросе значений
+// ширина корзины удваивается, пока диапазон не уложится в этот предел
+constexpr size_t MAX_BUCKETS = 256;
+
+// Обход выбранных строк: всех или из списка
+template<class F>
+void for_each_row(const CarStore& store, const std::vector<uint32_t>* rows, F&& f) {
+    if (!rows) {
+        for (uint32_t row = 0; row < store.size(); ++row) f(row);
+        return;
+    }
+    for (uint32_t row : *rows) f(row);
+}
+
+json value_counts(const CarStore& store, size_t column, const std::vector<uint32_t>* rows) {
+    const Dictionary& dictionary = store.dictionary(column);
+    std::vector<size_t> counts(dictionary.size());
+    if (!rows) {
+        for (uint32_t id = 0; id < dictionary.size(); ++id) {
+            counts[id] = static_cast<size_t>(store.index().find(column, id).cardinality());
+        }
+    }
+    else {
+        const Column<uint32_t>& values = store.string_values(column);
+        for (uint32_t row : *rows) {
+            if (values.has(row)) ++counts[values.values[row]];
+        }
+    }
+
+    json result = json::object();
+    for (uint32_t id = 0; id < counts.size(); ++id) {
+        if (counts[id] > 0) result[dictionary.value(id)] = counts[id];
+    }
+    return result;
+}
+
+template<class T>
+json histogram(const CarStore& store, const Column<T>& column, double width, const std::vector<uint32_t>* rows) {
+    T min = std::numeric_limits<T>::max();
+    T max = std::numeric_limits<T>::lowest();
+    size_t present = 0;
+    for_each_row(store, rows, [&](uint32_t row) {
+        if (!column.has(row)) return;
+        min = std::min(min, column.values[row]);
+        max = std::max(max, column.values[row]);
+        ++present;
+    });
+    if (present == 0) return nullptr;
+
+    // Половина диапазона конечна даже для крайних double, поэтому и деление
+    // на ширину не переполняется
+    const double half_range = static_cast<double>(max) / 2 - static_cast<double>(min) / 2;
+    while (half_range / width >= (MAX_BUCKETS - 1) / 2.0) width *= 2;
+
+    const double first = std::floor(static_cast<double>(min) / width);
+    std::vector<size_t> counts(static_cast<size_t>(std::floor(static_cast<double>(max) / width) - first) + 1);
+    for_each_row(store, rows, [&](uint32_t row) {
+        if (column.has(row)) {
+            size_t bucket = static_cast<size_t>(std::floor(static_cast<double>(column.values[row]) / width) - first);
+            ++counts[std::min(bucket, counts.size() - 1)];
+        }
+    });
+
+    json buckets = json::array();
+    for (size_t i = 0; i < counts.size(); ++i) {
+        if (counts[i] == 0) continue;
+        double from = (first + static_cast<double>(i)) * width;
+        json bucket;
+        if constexpr (std::is_integral_v<T>) bucket["from"] = static_cast<int64_t>(from);
+        else bucket["from"] = from;
+        bucket["count"] = counts[i];
+        buckets.push_back(std::move(bucket));
+    }
+
+    json result;
+    if constexpr (std::is_integral_v<T>) result["bucket"] = static_cast<int64_t>(width);
+    else result["bucket"] = width;
+    result["min"] = min;
+    result["max"] = max;
+    result["buckets"] = std::move(buckets);
+    return result;
+}
+
+} // namespace
+
+json car_facets(const CarStore& store, const std::vector<uint32_t>* rows) {
+    json values = json::object();
+    for (size_t column = 0; column < CarStore::STRING_FIELDS.size(); ++column) {
+        values[std::string(CarStore::STRING_FIELDS[column])] = value_counts(store, column, rows);
+    }
+
+    json histograms = json::object();
+    auto add = [&](size_t column, const auto& numbers) {
+        json result = histogram(store, numbers, BUCKET_WIDTH[column], rows);
+        if (!result.is_null()) histograms[std::string(CarStore::NUMERIC_FIELDS[column])] = std::move(result);
+    };
+    add(CarStore::Year, store.years());
+    add(CarStore::PriceUsd, store.prices());
+    add(CarStore::Horsepower, store.horsepowers());
+    add(CarStore::EngineVolume, store.engine_volumes());
+
+    json facets;
+    facets["found"] = rows ? rows->size() : store.size();
+    facets["values"] = std::move(values);
+    facets["histograms"] = std::move(histograms);
+    return facets;
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include "car_store.hpp"
+#include "../common/json.hpp"
+#include <cstdint>
+#include <vector>
+
+using json = nlohmann::json;
+
+// Фасеты каталога для фильтров интерфейса:
+// {"found": N,
+//  "values": {"brand": {"Toyota": 5, ...}, ...},
+//  "histograms": {"price_usd": {"bucket": 5000, "min": 9000, "max": 28000,
+//                               "buckets": [{"from": 5000, "count": 3}, ...]}, ...}}
+// Корзина гистограммы — [from, from + bucket), пустые корзины не выводятся.
+// Корзин не больше 256: при широком разбросе bucket кратно увеличивается.
+// Учитываются только типизированные значения столбцов.
+//
+// rows — выбранные строки по возрастанию; nullptr — весь каталог, тогда
+// число по строковым значениям берётся из мощности карт индекса (popcount),
+// иначе считается за один проход по столбцам выбранных строк.
+json car_facets(const CarStore& store, const std::vector<uint32_t>* rows);
@@ -0,0 +1,434 @@
+#include "car_filter.hpp"
+#include "simd_scan.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+
+namespace {
+
+constexpr double INF = std::numeric_limits<double>::infinity();
+
+// Целочисленные границы [lo, hi] для условия min <= v <= max по столбцу типа T;
+// false, если ни одно значение типа T не попадает в диапазон
+template<class T>
+bool integer_bounds(double min, double max, T& lo, T& hi) {
+    const double type_min = static_cast<double>(std::numeric_limits<T>::min());
+    const double type_max = static_cast<double>(std::numeric_limits<T>::max());
+    double low = std::ceil(min);
+    double high = std::floor(max);
+    if (low > high || low > type_max || high < type_min) return false;
+    lo = low < type_min ? std::numeric_limits<T>::min() : static_cast<T>(low);
+    hi = high > type_max ? std::numeric_limits<T>::max() : static_cast<T>(high);
+    return true;
+}
+
+// Строки, у которых значение столбца попадает хотя бы в одну из границ [lo, hi]
+template<class T>
+void scan_union(const Column<T>& column, size_t n, const std::vector<std::pair<T, T>>& bounds, Bitmap& bits) {
+    if (bounds.empty()) return;
+    Bitmap part(n);
+    for (size_t i = 0; i < bounds.size(); ++i) {
+        Bitmap& target = i == 0 ? bits : part;
+        scan_range(column.values.data(), n, bounds[i].first, bounds[i].second, target.data());
+        if (i > 0) bits |= part;
+    }
+    scan_and_present(column.present.data(), n, bits.data());
+}
+
+bool all_strings(const json& values) {
+    return std::all_of(values.begin(), values.end(), [](const json& value) { return value.is_string(); });
+}
+
+bool all_numbers(const json& values) {
+    return std::all_of(values.begin(), values.end(), [](const json& value) { return value.is_number(); });
+}
+
+} // namespace
+
+// === Компиляция ===
+
+std::vector<CarFilter::Test> CarFilter::parse_tests(const json& filter) {
+    static const std::pair<std::string_view, Op> OPERATORS[] = {
+        {"$eq", Op::Eq}, {"$ne", Op::Ne}, {"$gt", Op::Gt}, {"$gte", Op::Gte},
+        {"$lt", Op::Lt}, {"$lte", Op::Lte}, {"$in", Op::In}, {"$between", Op::Between}
+    };
+
+    // Простое значение — равенство
+    if (!filter.is_object()) return {Test{Op::Eq, filter}};
+
+    std::vector<Test> tests;
+    for (auto& [name, value] : filter.items()) {
+        auto it = std::find_if(std::begin(OPERATORS), std::end(OPERATORS),
+            [&](const auto& entry) { return entry.first == name; });
+        if (it == std::end(OPERATORS)) {
+            throw std::invalid_argument("Unknown filter operator: " + name);
+        }
+        if (it->second == Op::In && !value.is_array()) {
+            throw std::invalid_argument("Operator $in expects an array");
+        }
+        if (it->second == Op::Between && !(value.is_array() && value.size() == 2)) {
+            throw std::invalid_argument("Operator $between expects [from, to]");
+        }
+        tests.push_back({it->second, value});
+    }
+    return tests;
+}
+
+CarFilter::CarFilter(const CarStore& store, const json& filters) : store_(store) {
+    for (auto& [field, filter] : filters.items()) {
+        compile(field, filter);
+    }
+    for (auto& condition : conditions_) {
+        prepare(condition);
+    }
+    // Самые селективные условия проверяются первыми; при равной оценке
+    // сравнение JSON (дороже столбца) идёт последним
+    std::stable_sort(conditions_.begin(), conditions_.end(), [](const Condition& a, const Condition& b) {
+        bool a_generic = a.kind == Condition::Kind::Generic;
+        bool b_generic = b.kind == Condition::Kind::Generic;
+        return std::tie(a.estimate, a_generic) < std::tie(b.estimate, b_generic);
+    });
+}
+
+void CarFilter::compile(const std::string& field, const json& filter) {
+    std::vector<Test> tests = parse_tests(filter);
+    const int string_column = CarStore::string_column(field);
+    const int numeric_column = CarStore::numeric_column(field);
+
+    // Все сравнения с числами по числовому столбцу сводятся к одному диапазону
+    Condition range;
+    range.kind = Condition::Kind::Numeric;
+    range.field = field;
+    range.column = numeric_column;
+    double min = -INF, max = INF;
+
+    for (const auto& test : tests) {
+        Condition condition;
+        condition.field = field;
+        condition.tests = {test};
+        const json& value = test.value;
+
+        if (string_column >= 0) {
+            bool eq = (test.op == Op::Eq || test.op == Op::Ne) && value.is_string();
+            bool in = test.op == Op::In && all_strings(value);
+            if (eq || in) {
+                condition.kind = Condition::Kind::String;
+                condition.column = string_column;
+                condition.negate = test.op == Op::Ne;
+                const Dictionary& dictionary = store_.dictionary(string_column);
+                for (const json& item : eq ? json::array({value}) : value) {
+                    uint32_t id = dictionary.find(item.get<std::string>());
+                    if (id != Dictionary::NONE) condition.value_ids.push_back(id);
+                }
+                std::sort(condition.value_ids.begin(), condition.value_ids.end());
+                condition.value_ids.erase(std::unique(condition.value_ids.begin(), condition.value_ids.end()),
+                                          condition.value_ids.end());
+                conditions_.push_back(std::move(condition));
+                continue;
+            }
+        }
+        else if (numeric_column >= 0) {
+            bool bound = test.op == Op::Between ? all_numbers(value)
+                                                : test.op != Op::In && test.op != Op::Ne && value.is_number();
+            if (bound) {
+                double a = test.op == Op::Between ? value[0].get<double>() : value.get<double>();
+                switch (test.op) {
+                    case Op::Eq: min = std::max(min, a); max = std::min(max, a); break;
+                    case Op::Gt: min = std::max(min, std::nextafter(a, INF)); break;
+                    case Op::Gte: min = std::max(min, a); break;
+                    case Op::Lt: max = std::min(max, std::nextafter(a, -INF)); break;
+                    case Op::Lte: max = std::min(max, a); break;
+                    case Op::Between: min = std::max(min, a); max = std::min(max, value[1].get<double>()); break;
+                    default: break;
+                }
+                range.tests.push_back(test);
+                continue;
+            }
+            bool ne = test.op == Op::Ne && value.is_number();
+            if (ne || (test.op == Op::In && all_numbers(value))) {
+                condition.kind = Condition::Kind::Numeric;
+                condition.column = numeric_column;
+                condition.negate = ne;
+                for (const json& item : ne ? json::array({value}) : value) {
+                    double point = item.get<double>();
+                    condition.ranges.emplace_back(point, point);
+                }
+                std::sort(condition.ranges.begin(), condition.ranges.end());
+                condition.ranges.erase(std::unique(condition.ranges.begin(), condition.ranges.end()),
+                                       condition.ranges.end());
+                conditions_.push_back(std::move(condition));
+                continue;
+            }
+        }
+        // Прочие поля и сравнения с другими типами — как JSON
+        conditions_.push_back(std::move(condition));
+    }
+
+    if (!range.tests.empty()) {
+        if (min <= max) range.ranges.emplace_back(min, max);
+        conditions_.push_back(std::move(range));
+    }
+    // Пустой объект операторов: достаточно наличия поля
+    if (tests.empty()) {
+        Condition exists;
+        exists.field = field;
+        conditions_.push_back(std::move(exists));
+    }
+}
+
+void CarFilter::prepare(Condition& condition) const {
+    const CarIndex& index = store_.index();
+    const size_t n = store_.size();
+    size_t selected = n;
+
+    if (condition.kind == Condition::Kind::String) {
+        // Значения одного столбца у строки не пересекаются: размер $in — сумма карт
+        if (condition.value_ids.size() == 1) {
+            condition.postings = &index.find(condition.column, condition.value_ids.front());
+        }
+        else if (condition.value_ids.empty()) {
+            condition.postings = &index.find(condition.column, Dictionary::NONE);
+        }
+        else {
+            RoaringBitmap merged;
+            for (uint32_t id : condition.value_ids) merged = merged | index.find(condition.column, id);
+            condition.merged = std::make_shared<const RoaringBitmap>(std::move(merged));
+            condition.postings = condition.merged.get();
+        }
+        selected = static_cast<size_t>(condition.postings->cardinality());
+    }
+    else if (condition.kind == Condition::Kind::Numeric) {
+        // Нетипизированные значения входят в каждую оценку find_range, учитываются один раз
+        size_t untyped = index.untyped(condition.column).size();
+        selected = untyped;
+        for (const auto& [min, max] : condition.ranges) {
+            selected += index.estimate_range(condition.column, min, max) - untyped;
+        }
+    }
+
+    condition.estimate = condition.negate ? n - std::min(selected, n) : selected;
+}
+
+// === Проверка строк ===
+
+bool CarFilter::test_matches(const Test& test, const json& value) {
+    switch (test.op) {
+        case Op::Eq: return value == test.value;
+        case Op::Ne: return value != test.value;
+        case Op::Gt: return value > test.value;
+        case Op::Gte: return value >= test.value;
+        case Op::Lt: return value < test.value;
+        case Op::Lte: return value <= test.value;
+        case Op::In:
+            return std::find(test.value.begin(), test.value.end(), value) != test.value.end();
+        case Op::Between: return value >= test.value[0] && value <= test.value[1];
+    }
+    return false;
+}
+
+bool CarFilter::tests_match(const Condition& condition, const json& value) {
+    for (const auto& test : condition.tests) {
+        if (!test_matches(test, value)) return false;
+    }
+    return true;
+}
+
+bool CarFilter::indexed(const Condition& condition) {
+    return condition.kind != Condition::Kind::Generic && !condition.negate;
+}
+
+bool CarFilter::matches(uint32_t row) const {
+    for (const auto& condition : conditions_) {
+        if (!matches(condition, row)) return false;
+    }
+    return true;
+}
+
+bool CarFilter::matches(const Condition& condition, uint32_t row) const {
+    switch (condition.kind) {
+        case Condition::Kind::String: {
+            uint32_t id;
+            if (store_.string_id(condition.column, row, id)) {
+                bool found = std::binary_search(condition.value_ids.begin(), condition.value_ids.end(), id);
+                return found != condition.negate;
+            }
+            break;
+        }
+        case Condition::Kind::Numeric: {
+            double value;
+            if (store_.numeric(condition.column, row, value)) {
+                bool found = std::any_of(condition.ranges.begin(), condition.ranges.end(),
+                    [&](const std::pair<double, double>& range) { return value >= range.first && value <= range.second; });
+                return found != condition.negate;
+            }
+            break;
+        }
+        case Condition::Kind::Generic: {
+            json value;
+            return store_.value(row, condition.field, value) && tests_match(condition, value);
+        }
+    }
+    // Значение не в столбце (нетипизированное) — сравнение JSON
+    const json* extra = store_.extra(row, condition.field);
+    return extra && tests_match(condition, *extra);
+}
+
+// === Поиск ===
+
+RoaringBitmap CarFilter::string_postings() const {
+    // Условия упорядочены по мощности карт — пересечение начинается с самых коротких
+    RoaringBitmap selected;
+    bool first = true;
+    for (const auto& condition : conditions_) {
+        if (condition.kind != Condition::Kind::String || condition.negate) continue;
+        selected = first ? *condition.postings : selected & *condition.postings;
+        first = false;
+        if (selected.empty()) break;
+    }
+    return selected;
+}
+
+CarIndex::Postings CarFilter::range_rows(const Condition& condition) const {
+    const CarIndex& index = store_.index();
+    if (condition.ranges.size() == 1) {
+        return index.find_range(condition.column, condition.ranges[0].first, condition.ranges[0].second);
+    }
+    CarIndex::Postings rows = index.untyped(condition.column);
+    for (const auto& [min, max] : condition.ranges) {
+        CarIndex::Postings part = index.find_range(condition.column, min, max);
+        rows.insert(rows.end(), part.begin(), part.end());
+    }
+    std::sort(rows.begin(), rows.end());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+    return rows;
+}
+
+std::vector<uint32_t> CarFilter::search() const {
+    // Условия упорядочены: первое с индексом — самое селективное
+    const Condition* driver = nullptr;
+    bool only_strings = true;
+    for (const auto& condition : conditions_) {
+        if (!driver && indexed(condition)) driver = &condition;
+        if (condition.kind != Condition::Kind::String || condition.negate) only_strings = false;
+    }
+
+    std::vector<uint32_t> rows;
+    if (!driver) {
+        for (uint32_t row = 0; row < store_.size(); ++row) {
+            if (matches(row)) rows.push_back(row);
+        }
+        return rows;
+    }
+
+    // Только равенства и $in по строковым полям: результат — пересечение карт
+    if (only_strings) return string_postings().to_vector();
+
+    // Выборка не меньше 1/SCAN_RATIO каталога — просмотр столбцов
+    if (driver->estimate * SCAN_RATIO >= store_.size()) {
+        return scan_columns();
+    }
+
+    // Кандидаты берутся из индекса самого селективного условия,
+    // остальные условия проверяются у кандидатов
+    if (driver->kind == Condition::Kind::Numeric) {
+        for (uint32_t row : range_rows(*driver)) {
+            if (matches(row)) rows.push_back(row);
+        }
+        return rows;
+    }
+    string_postings().for_each([&](uint32_t row) {
+        if (matches(row)) rows.push_back(row);
+    });
+    return rows;
+}
+
+size_t CarFilter::count() const {
+    if (conditions_.empty()) return store_.size();
+    std::vector<const RoaringBitmap*> postings;
+    for (const auto& condition : conditions_) {
+        if (condition.kind != Condition::Kind::String || condition.negate) return search().size();
+        postings.push_back(condition.postings);
+    }
+
+    // Только равенства по строковым полям: мощность пересечения считается
+    // по блокам карт (popcount для плотных), позиции не извлекаются
+    if (postings.size() == 1) return static_cast<size_t>(postings.front()->cardinality());
+    RoaringBitmap selected = *postings.front();
+    for (size_t i = 1; i + 1 < postings.size() && !selected.empty(); ++i) selected = selected & *postings[i];
+    return static_cast<size_t>(RoaringBitmap::and_cardinality(selected, *postings.back()));
+}
+
+std::vector<uint32_t> CarFilter::scan_columns() const {
+    Bitmap selected;
+    bool first = true;
+    // Проверка строки нужна только для условий, которые карта не решает:
+    // по полям вне столбцов, $ne и по нетипизированным значениям
+    bool verify = false;
+    for (const auto& condition : conditions_) {
+        if (!indexed(condition)) {
+            verify = true;
+            continue;
+        }
+        if (condition.kind == Condition::Kind::Numeric && !store_.index().untyped(condition.column).empty()) {
+            verify = true;
+        }
+        Bitmap bits = column_bitmap(condition);
+        if (first) {
+            selected = std::move(bits);
+            first = false;
+        }
+        else {
+            selected &= bits;
+        }
+    }
+
+    std::vector<uint32_t> rows;
+    rows.reserve(selected.count());
+    selected.for_each([&](uint32_t row) {
+        if (!verify || matches(row)) rows.push_back(row);
+    });
+    return rows;
+}
+
+Bitmap CarFilter::column_bitmap(const Condition& condition) const {
+    const size_t n = store_.size();
+    Bitmap bits(n);
+
+    if (condition.kind == Condition::Kind::String) {
+        // Равенство строки — диапазон [id, id] по столбцу номеров словаря
+        std::vector<std::pair<uint32_t, uint32_t>> bounds;
+        for (uint32_t id : condition.value_ids) bounds.emplace_back(id, id);
+        scan_union(store_.string_values(condition.column), n, bounds, bits);
+        return bits;
+    }
+
+    auto scan = [&](const auto& column) {
+        using T = typename std::decay_t<decltype(column.values)>::value_type;
+        std::vector<std::pair<T, T>> bounds;
+        for (const auto& [min, max] : condition.ranges) {
+            if constexpr (std::is_floating_point_v<T>) {
+                bounds.emplace_back(min, max);
+            }
+            else {
+                T lo, hi;
+                if (integer_bounds(min, max, lo, hi)) bounds.emplace_back(lo, hi);
+            }
+        }
+        scan_union(column, n, bounds, bits);
+    };
+    switch (condition.column) {
+        case CarStore::Year: scan(store_.years()); break;
+        case CarStore::PriceUsd: scan(store_.prices()); break;
+        case CarStore::Horsepower: scan(store_.horsepowers()); break;
+        case CarStore::EngineVolume: scan(store_.engine_volumes()); break;
+    }
+    // Нетипизированные значения проверяются при обходе карты
+    for (uint32_t row : store_.index().untyped(condition.column)) {
+        bits.set(row);
+    }
+    return bits;
+}
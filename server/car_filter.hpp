@@ -0,0 +1,92 @@
+#pragma once
+#include "bitmap.hpp"
+#include "car_store.hpp"
+#include "../common/json.hpp"
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+using json = nlohmann::json;
+
+// Фильтр поиска автомобилей, скомпилированный под столбцы CarStore.
+// Формат фильтров: {"поле": значение} (равенство) или {"поле": {"оп": значение, ...}}
+// с операторами $eq, $ne, $gt, $gte, $lt, $lte, $in (массив значений) и
+// $between ([от, до], включительно); операторы одного поля объединяются по И.
+// Неизвестный оператор — ошибка std::invalid_argument. Условие выполняется,
+// только если поле у автомобиля есть.
+//
+// Фильтр разбирается один раз: поля заменяются номерами столбцов, строки —
+// номерами словаря, границы — числами (строгие границы переводятся в
+// нестрогие), а условия упорядочиваются по оценке селективности, поэтому
+// проверка строки обрывается на самом редком условии. Значения вне столбцов
+// (прочие поля и нетипизированные значения) сравниваются как JSON, поэтому
+// результат совпадает с проверкой исходных объектов.
+class CarFilter {
+public:
+    CarFilter(const CarStore& store, const json& filters);
+
+    bool matches(uint32_t row) const;
+
+    // Позиции подходящих автомобилей по возрастанию. Поиск начинается с самого
+    // селективного условия, у которого есть индекс: равенства и $in по
+    // строковым полям (карты пересекаются как сжатые битовые карты) или
+    // диапазоны и $in по числовым полям (размер оценивается двоичным поиском);
+    // прочие условия проверяются только у кандидатов. Если даже лучший индекс
+    // выбирает большую часть каталога, условия по столбцам вычисляются
+    // векторными ядрами в битовые карты и объединяются по AND. Без условий
+    // с индексом — полный просмотр.
+    std::vector<uint32_t> search() const;
+
+    // Число подходящих автомобилей. Для условий только на строковые поля
+    // считается по картам индекса без построения списка позиций.
+    size_t count() const;
+
+private:
+    enum class Op { Eq, Ne, Gt, Gte, Lt, Lte, In, Between };
+
+    // Оператор с операндом в исходном виде — для сравнения значений как JSON
+    struct Test {
+        Op op;
+        json value;
+    };
+
+    struct Condition {
+        enum class Kind { String, Numeric, Generic };
+        Kind kind = Kind::Generic;
+        std::string field;
+        std::vector<Test> tests;                       // операторы, которые покрывает условие
+        int column = -1;
+        bool negate = false;                           // $ne: значение вне множества
+        std::vector<uint32_t> value_ids;               // Kind::String: номера словаря по возрастанию
+        std::vector<std::pair<double, double>> ranges; // Kind::Numeric: объединение [min, max]
+        const RoaringBitmap* postings = nullptr;       // Kind::String без negate: позиции
+        std::shared_ptr<const RoaringBitmap> merged;   // объединение карт для $in
+        size_t estimate = 0;                           // оценка числа подходящих строк
+    };
+
+    // Просмотр столбцов выгоднее индекса, если по оценке условию отвечает
+    // не меньше 1/SCAN_RATIO строк каталога
+    static constexpr size_t SCAN_RATIO = 16;
+
+    static std::vector<Test> parse_tests(const json& filter);
+    static bool test_matches(const Test& test, const json& value);
+    static bool tests_match(const Condition& condition, const json& value);
+    // Условие, которое можно начать с индекса
+    static bool indexed(const Condition& condition);
+
+    void compile(const std::string& field, const json& filter);
+    void prepare(Condition& condition) const;
+
+    bool matches(const Condition& condition, uint32_t row) const;
+    // Пересечение карт строковых условий
+    RoaringBitmap string_postings() const;
+    // Позиции из упорядоченного индекса для числового условия
+    CarIndex::Postings range_rows(const Condition& condition) const;
+    std::vector<uint32_t> scan_columns() const;
+    // Битовая карта строк, у которых значение в столбце удовлетворяет условию
+    Bitmap column_bitmap(const Condition& condition) const;
+
+    const CarStore& store_;
+    std::vector<Condition> conditions_; // по возрастанию оценки
+};
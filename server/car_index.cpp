@@ -0,0 +1,161 @@
+#include "car_index.hpp"
+#include "car_store.hpp"
+#include <algorithm>
+
+namespace {
+
+const RoaringBitmap EMPTY_POSTINGS;
+
+using RangeValues = std::vector<std::pair<double, uint32_t>>;
+
+// Границы записей со значением в [min, max]
+std::pair<RangeValues::const_iterator, RangeValues::const_iterator>
+value_range(const RangeValues& values, double min, double max) {
+    auto first = std::lower_bound(values.begin(), values.end(), min,
+        [](const std::pair<double, uint32_t>& entry, double value) { return entry.first < value; });
+    auto last = std::upper_bound(first, values.end(), max,
+        [](double value, const std::pair<double, uint32_t>& entry) { return value < entry.first; });
+    return {first, last};
+}
+
+void insert_sorted(CarIndex::Postings& postings, uint32_t row) {
+    postings.insert(std::lower_bound(postings.begin(), postings.end(), row), row);
+}
+
+void erase_sorted(CarIndex::Postings& postings, uint32_t row) {
+    auto pos = std::lower_bound(postings.begin(), postings.end(), row);
+    if (pos != postings.end() && *pos == row) postings.erase(pos);
+}
+
+// Сдвиг позиций больше row на одну назад (после удаления строки row)
+void shift_after(CarIndex::Postings& postings, uint32_t row) {
+    auto it = std::upper_bound(postings.begin(), postings.end(), row);
+    for (; it != postings.end(); ++it) --*it;
+}
+
+} // namespace
+
+RoaringBitmap& CarIndex::postings(const CarStore& store, size_t column, uint32_t value_id) {
+    auto& values = strings_[column];
+    while (values.size() <= value_id) {
+        uint32_t id = static_cast<uint32_t>(values.size());
+        texts_[column].add(id, store.dictionary(column).value(id));
+        values.emplace_back();
+    }
+    return values[value_id];
+}
+
+void CarIndex::build(const CarStore& store) {
+    for (auto& column : strings_) column.clear();
+    for (auto& text : texts_) text = TextIndex();
+    for (auto& range : ranges_) range = RangeIndex();
+    rows_ = store.size();
+
+    for (uint32_t row = 0; row < rows_; ++row) {
+        for (size_t i = 0; i < STRING_COLUMNS; ++i) {
+            uint32_t id;
+            if (!store.string_id(i, row, id)) continue;
+            postings(store, i, id).add(row);
+        }
+        for (size_t i = 0; i < NUMERIC_COLUMNS; ++i) {
+            double value;
+            if (store.numeric(i, row, value)) {
+                ranges_[i].values.emplace_back(value, row);
+            }
+            else if (store.extra(row, CarStore::NUMERIC_FIELDS[i])) {
+                ranges_[i].others.push_back(row);
+            }
+        }
+    }
+    // Числовые индексы сортируются один раз, а не вставками по одной строке
+    for (auto& range : ranges_) {
+        std::sort(range.values.begin(), range.values.end());
+    }
+}
+
+void CarIndex::append(const CarStore& store, uint32_t row) {
+    ++rows_;
+    insert(store, row);
+}
+
+void CarIndex::insert(const CarStore& store, uint32_t row) {
+    for (size_t i = 0; i < STRING_COLUMNS; ++i) {
+        uint32_t id;
+        if (!store.string_id(i, row, id)) continue;
+        postings(store, i, id).add(row);
+    }
+    for (size_t i = 0; i < NUMERIC_COLUMNS; ++i) {
+        RangeIndex& range = ranges_[i];
+        double value;
+        if (store.numeric(i, row, value)) {
+            std::pair<double, uint32_t> entry(value, row);
+            range.values.insert(std::lower_bound(range.values.begin(), range.values.end(), entry), entry);
+        }
+        else if (store.extra(row, CarStore::NUMERIC_FIELDS[i])) {
+            insert_sorted(range.others, row);
+        }
+    }
+}
+
+void CarIndex::erase(const CarStore& store, uint32_t row) {
+    for (size_t i = 0; i < STRING_COLUMNS; ++i) {
+        uint32_t id;
+        if (store.string_id(i, row, id) && id < strings_[i].size()) {
+            strings_[i][id].remove(row);
+        }
+    }
+    for (size_t i = 0; i < NUMERIC_COLUMNS; ++i) {
+        RangeIndex& range = ranges_[i];
+        double value;
+        if (store.numeric(i, row, value)) {
+            std::pair<double, uint32_t> entry(value, row);
+            auto pos = std::lower_bound(range.values.begin(), range.values.end(), entry);
+            if (pos != range.values.end() && *pos == entry) range.values.erase(pos);
+        }
+        else {
+            erase_sorted(range.others, row);
+        }
+    }
+}
+
+void CarIndex::remove(const CarStore& store, uint32_t row) {
+    erase(store, row);
+    // Позиции за удалённой строкой сдвигаются на одну назад
+    for (auto& column : strings_) {
+        for (auto& postings : column) {
+            postings.remove_and_shift(row);
+        }
+    }
+    for (auto& range : ranges_) {
+        for (auto& entry : range.values) {
+            if (entry.second > row) --entry.second;
+        }
+        shift_after(range.others, row);
+    }
+    --rows_;
+}
+
+const RoaringBitmap& CarIndex::find(size_t column, uint32_t value_id) const {
+    if (value_id >= strings_[column].size()) return EMPTY_POSTINGS;
+    return strings_[column][value_id];
+}
+
+CarIndex::Postings CarIndex::find_range(size_t column, double min, double max) const {
+    if (min > max) return {};
+    const RangeIndex& range = ranges_[column];
+    auto [first, last] = value_range(range.values, min, max);
+
+    Postings result;
+    result.reserve(static_cast<size_t>(last - first) + range.others.size());
+    for (auto it = first; it != last; ++it) result.push_back(it->second);
+    result.insert(result.end(), range.others.begin(), range.others.end());
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+size_t CarIndex::estimate_range(size_t column, double min, double max) const {
+    if (min > max) return 0;
+    const RangeIndex& range = ranges_[column];
+    auto [first, last] = value_range(range.values, min, max);
+    return static_cast<size_t>(last - first) + range.others.size();
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "roaring.hpp"
+#include "text_index.hpp"
+
+class CarStore;
+
+// Индексы автомобилей по столбцам CarStore. Категориальные поля — хэш-индекс:
+// номер значения в словаре столбца -> сжатая битовая карта позиций
+// автомобилей. Карты объединяются по AND/OR поблочно, а обход идёт по
+// возрастанию позиций, в том же порядке, что и полный просмотр. Числовые поля — упорядоченный индекс
+// (значение, позиция) для условий $gte/$lte: диапазон находится двоичным поиском.
+// Индекс принадлежит хранилищу и обновляется вместе с ним.
+class CarIndex {
+public:
+    using Postings = std::vector<uint32_t>;
+
+    static constexpr size_t STRING_COLUMNS = 5;  // CarStore::STRING_FIELDS
+    static constexpr size_t NUMERIC_COLUMNS = 4; // CarStore::NUMERIC_FIELDS
+
+    // Построение индекса по всему хранилищу
+    void build(const CarStore& store);
+
+    // Строка row добавлена в конец хранилища
+    void append(const CarStore& store, uint32_t row);
+    // Добавление/удаление значений строки row без сдвига позиций
+    // (изменение строки: erase до него, insert после)
+    void insert(const CarStore& store, uint32_t row);
+    void erase(const CarStore& store, uint32_t row);
+    // Строка row удаляется из хранилища (вызывается до удаления),
+    // последующие позиции сдвигаются
+    void remove(const CarStore& store, uint32_t row);
+
+    // Позиции автомобилей со значением номер value_id в строковом столбце
+    const RoaringBitmap& find(size_t column, uint32_t value_id) const;
+
+    // Позиции автомобилей с min <= значение <= max (по возрастанию позиций).
+    // Автомобили, у которых поле есть, но хранится нетипизированным (в extras),
+    // включаются всегда: сравнение json разных типов не числовое, их проверяет
+    // вызывающий.
+    Postings find_range(size_t column, double min, double max) const;
+    // Оценка числа позиций, которые вернёт find_range, без их извлечения
+    size_t estimate_range(size_t column, double min, double max) const;
+
+    // Значения строкового столбца для подсказок и поиска без учёта регистра;
+    // пополняется новыми значениями словаря вместе с картами
+    const TextIndex& text(size_t column) const { return texts_[column]; }
+
+    // Позиции автомобилей, у которых числовое поле есть, но не в столбце
+    const Postings& untyped(size_t column) const { return ranges_[column].others; }
+
+    size_t size() const { return rows_; }
+
+private:
+    // Упорядоченный индекс числового поля
+    struct RangeIndex {
+        std::vector<std::pair<double, uint32_t>> values; // по возрастанию (значение, позиция)
+        Postings others;                                 // поле есть, но не в столбце
+    };
+
+    // Карта для номера value_id; новые значения словаря добавляются в texts_
+    RoaringBitmap& postings(const CarStore& store, size_t column, uint32_t value_id);
+
+    std::array<std::vector<RoaringBitmap>, STRING_COLUMNS> strings_; // [столбец][номер значения]
+    std::array<TextIndex, STRING_COLUMNS> texts_;
+    std::array<RangeIndex, NUMERIC_COLUMNS> ranges_;
+    size_t rows_ = 0;
+};
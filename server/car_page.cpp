@@ -0,0 +1,69 @@
+#include "car_page.hpp"
+#include <algorithm>
+
+namespace {
+
+struct Entry {
+    double key;
+    uint32_t row;
+    bool missing; // значения нет — после всех значений
+};
+
+// Порядок выдачи: по ключу (возрастание или убывание), затем по позиции
+struct EntryLess {
+    bool descending;
+
+    bool operator()(const Entry& a, const Entry& b) const {
+        if (a.missing != b.missing) return !a.missing;
+        if (!a.missing && a.key != b.key) return descending ? a.key > b.key : a.key < b.key;
+        return a.row < b.row;
+    }
+};
+
+} // namespace
+
+std::optional<double> sort_key(const CarStore& store, int column, uint32_t row) {
+    double value;
+    if (store.numeric(column, row, value)) return value;
+    return std::nullopt;
+}
+
+Page select_page(const CarStore& store, const std::vector<uint32_t>& rows, const PageRequest& request) {
+    Page page;
+
+    // Порядок каталога: rows уже упорядочены, страница — срез после курсора
+    if (request.sort_column < 0) {
+        auto begin = request.after_row ? std::upper_bound(rows.begin(), rows.end(), *request.after_row)
+                                       : rows.begin();
+        size_t available = static_cast<size_t>(rows.end() - begin);
+        if (request.offset >= available) return page;
+        size_t take = std::min(request.limit, available - request.offset);
+        page.rows.assign(begin + request.offset, begin + request.offset + take);
+        page.more = request.offset + take < available;
+        return page;
+    }
+
+    EntryLess less{request.descending};
+    std::optional<Entry> boundary;
+    if (request.after_row) {
+        boundary = Entry{request.after_key.value_or(0), *request.after_row, !request.after_key};
+    }
+
+    std::vector<Entry> entries;
+    entries.reserve(rows.size());
+    for (uint32_t row : rows) {
+        std::optional<double> key = sort_key(store, request.sort_column, row);
+        Entry entry{key.value_or(0), row, !key};
+        if (boundary && !less(*boundary, entry)) continue;
+        entries.push_back(entry);
+    }
+    if (request.offset >= entries.size()) return page;
+
+    // Сортируются только строки до конца страницы
+    size_t end = request.offset + std::min(request.limit, entries.size() - request.offset);
+    std::partial_sort(entries.begin(), entries.begin() + static_cast<std::ptrdiff_t>(end), entries.end(), less);
+    page.rows.reserve(end - request.offset);
+    for (size_t i = request.offset; i < end; ++i) page.rows.push_back(entries[i].row);
+    page.more = end < entries.size();
+    return page;
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include "car_store.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <vector>
+
+// Порядок выдачи и граница страницы результатов поиска
+struct PageRequest {
+    int sort_column = -1; // числовой столбец CarStore; -1 — порядок каталога
+    bool descending = false;
+    // Курсор: выдача продолжается после строки after_row с ключом
+    // сортировки after_key (nullopt — значения у строки нет)
+    std::optional<uint32_t> after_row;
+    std::optional<double> after_key;
+    size_t offset = 0;
+    size_t limit = std::numeric_limits<size_t>::max();
+};
+
+struct Page {
+    std::vector<uint32_t> rows; // строки страницы в порядке выдачи
+    bool more = false;          // после страницы есть ещё строки
+};
+
+// Ключ сортировки строки: значение числового столбца, если оно типизировано
+std::optional<double> sort_key(const CarStore& store, int column, uint32_t row);
+
+// Страница из подходящих строк rows (по возрастанию позиций). Автомобили без
+// значения поля сортировки (или с нетипизированным значением) идут последними,
+// при равных ключах — в порядке каталога. Упорядочиваются только первые
+// offset + limit строк (частичная сортировка кучей), а не весь результат.
+Page select_page(const CarStore& store, const std::vector<uint32_t>& rows, const PageRequest& request);
@@ -0,0 +1,265 @@
+#include "car_snapshot.hpp"
+#include "wal.hpp"
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <type_traits>
+#include <unistd.h>
+
+namespace {
+
+constexpr char MAGIC[8] = {'C', 'A', 'R', 'S', 'N', 'A', 'P', '\0'};
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint64_t rows;
+    int64_t next_id;
+    uint64_t payload_size;
+    uint64_t checksum;
+};
+static_assert(sizeof(Header) % 8 == 0, "payload must stay 8-byte aligned");
+
+// Контрольная сумма по 8-байтовым словам (не криптографическая: ловит
+// оборванную запись и порчу файла, читается быстрее побайтовой)
+uint64_t checksum(std::string_view data) {
+    uint64_t hash = 0x9E3779B97F4A7C15ull ^ data.size();
+    size_t i = 0;
+    for (; i + 8 <= data.size(); i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data.data() + i, 8);
+        hash = (hash ^ word) * 0xFF51AFD7ED558CCDull;
+        hash ^= hash >> 32;
+    }
+    for (; i < data.size(); ++i) {
+        hash = (hash ^ static_cast<unsigned char>(data[i])) * 0x100000001B3ull;
+    }
+    return hash ^ (hash >> 29);
+}
+
+class Writer {
+public:
+    template<class T>
+    void put(const T& value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        out_.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template<class T>
+    void put_array(const ColumnArray<T>& values) {
+        out_.append(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+        align();
+    }
+
+    template<class T>
+    void put_column(const Column<T>& column) {
+        put_array(column.values);
+        put_array(column.present);
+    }
+
+    // Строки: число, смещения (count + 1) и байты подряд
+    template<class Get>
+    void put_strings(size_t count, Get get) {
+        put<uint64_t>(count);
+        uint64_t offset = 0;
+        put<uint64_t>(offset);
+        for (size_t i = 0; i < count; ++i) {
+            offset += get(i).size();
+            put<uint64_t>(offset);
+        }
+        for (size_t i = 0; i < count; ++i) out_ += get(i);
+        align();
+    }
+
+    std::string& data() { return out_; }
+
+private:
+    void align() { out_.resize((out_.size() + 7) & ~size_t(7), '\0'); }
+
+    std::string out_;
+};
+
+class Reader {
+public:
+    // mapping — владелец data: столбцы ссылаются на данные вместо копирования
+    Reader(std::string_view data, std::shared_ptr<const void> mapping)
+        : data_(data), mapping_(std::move(mapping)) {}
+
+    template<class T>
+    T get() {
+        T value;
+        std::memcpy(&value, take(sizeof(T)), sizeof(T));
+        return value;
+    }
+
+    template<class T>
+    void get_array(ColumnArray<T>& values, size_t count) {
+        if (count > remaining() / sizeof(T)) fail();
+        const char* at = take(count * sizeof(T));
+        // Секции выровнены на 8 байт от начала файла, а mmap выравнивает
+        // начало по странице, поэтому указатель годится для T
+        if (mapping_ && reinterpret_cast<uintptr_t>(at) % alignof(T) == 0) {
+            values = ColumnArray<T>(mapping_, reinterpret_cast<const T*>(at), count);
+        }
+        else {
+            std::vector<T> copy(count);
+            std::memcpy(copy.data(), at, count * sizeof(T));
+            values.assign(copy.data(), count);
+        }
+        align();
+    }
+
+    template<class T>
+    void get_column(Column<T>& column, size_t rows) {
+        get_array(column.values, rows);
+        get_array(column.present, rows);
+    }
+
+    template<class Put>
+    void get_strings(Put put) {
+        uint64_t count = get<uint64_t>();
+        // Таблица смещений должна поместиться в остаток данных
+        if (count >= remaining() / 8) fail();
+        std::vector<uint64_t> offsets(count + 1);
+        std::memcpy(offsets.data(), take(offsets.size() * 8), offsets.size() * 8);
+        const char* bytes = take(offsets.back());
+        for (size_t i = 0; i < count; ++i) {
+            if (offsets[i] > offsets[i + 1] || offsets[i + 1] > offsets.back()) fail();
+            put(std::string_view(bytes + offsets[i], offsets[i + 1] - offsets[i]));
+        }
+        align();
+    }
+
+    bool done() const { return pos_ == data_.size(); }
+    size_t remaining() const { return data_.size() - pos_; }
+
+private:
+    [[noreturn]] static void fail() { throw std::runtime_error("Car snapshot is truncated"); }
+
+    const char* take(size_t size) {
+        if (size > data_.size() - pos_) fail();
+        const char* at = data_.data() + pos_;
+        pos_ += size;
+        return at;
+    }
+
+    void align() {
+        size_t aligned = (pos_ + 7) & ~size_t(7);
+        pos_ = aligned < data_.size() ? aligned : data_.size();
+    }
+
+    std::string_view data_;
+    std::shared_ptr<const void> mapping_;
+    size_t pos_ = 0;
+};
+
+} // namespace
+
+std::string CarSnapshot::encode(const CarStore& store) {
+    Writer writer;
+    writer.put_column(store.id_);
+    writer.put_column(store.year_);
+    writer.put_column(store.price_usd_);
+    writer.put_column(store.horsepower_);
+    writer.put_column(store.engine_volume_);
+    for (const auto& column : store.strings_) writer.put_column(column);
+    for (const auto& dictionary : store.dictionaries_) {
+        writer.put_strings(dictionary.size(), [&](size_t i) -> const std::string& { return dictionary.value(static_cast<uint32_t>(i)); });
+    }
+    std::vector<std::string> extras(store.size());
+    for (size_t row = 0; row < extras.size(); ++row) {
+        if (!store.extras_[row].is_null()) extras[row] = store.extras_[row].dump();
+    }
+    writer.put_strings(extras.size(), [&](size_t i) -> const std::string& { return extras[i]; });
+
+    std::string payload = std::move(writer.data());
+    Header header;
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = FORMAT_VERSION;
+    header.header_size = sizeof(Header);
+    header.rows = store.size();
+    header.next_id = store.ids_.next_id();
+    header.payload_size = payload.size();
+    header.checksum = checksum(payload);
+
+    std::string out(reinterpret_cast<const char*>(&header), sizeof(Header));
+    out += payload;
+    return out;
+}
+
+CarStore CarSnapshot::decode(std::string_view data, std::shared_ptr<const void> mapping) {
+    Header header;
+    if (data.size() < sizeof(Header)) throw std::runtime_error("Car snapshot is truncated");
+    std::memcpy(&header, data.data(), sizeof(Header));
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) throw std::runtime_error("Not a car snapshot");
+    if (header.version != FORMAT_VERSION || header.header_size != sizeof(Header)) {
+        throw std::runtime_error("Unsupported car snapshot version " + std::to_string(header.version));
+    }
+    std::string_view payload = data.substr(sizeof(Header));
+    if (payload.size() != header.payload_size) throw std::runtime_error("Car snapshot is truncated");
+    if (checksum(payload) != header.checksum) throw std::runtime_error("Car snapshot checksum mismatch");
+
+    CarStore store;
+    const size_t rows = header.rows;
+    Reader reader(payload, std::move(mapping));
+    reader.get_column(store.id_, rows);
+    reader.get_column(store.year_, rows);
+    reader.get_column(store.price_usd_, rows);
+    reader.get_column(store.horsepower_, rows);
+    reader.get_column(store.engine_volume_, rows);
+    for (auto& column : store.strings_) reader.get_column(column, rows);
+    for (size_t i = 0; i < store.dictionaries_.size(); ++i) {
+        Dictionary& dictionary = store.dictionaries_[i];
+        reader.get_strings([&](std::string_view value) { dictionary.intern(std::string(value)); });
+        for (uint32_t row = 0; row < rows; ++row) {
+            if (store.strings_[i].has(row) && store.strings_[i].values[row] >= dictionary.size()) {
+                throw std::runtime_error("Car snapshot has invalid string ids");
+            }
+        }
+    }
+    store.extras_.reserve(rows);
+    reader.get_strings([&](std::string_view extra) {
+        store.extras_.push_back(extra.empty() ? json() : json::parse(extra));
+    });
+    if (store.extras_.size() != rows || !reader.done()) throw std::runtime_error("Car snapshot is malformed");
+
+    for (uint32_t row = 0; row < rows; ++row) {
+        if (store.id_.has(row)) store.ids_.insert(store.id_.values[row], row);
+    }
+    store.ids_.reserve_ids(static_cast<int32_t>(header.next_id));
+    store.index_.build(store);
+    return store;
+}
+
+bool CarSnapshot::write(const CarStore& store, const std::string& path) {
+    return write_file_atomically(path, encode(store));
+}
+
+std::optional<CarStore> CarSnapshot::read(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return std::nullopt;
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        throw std::runtime_error("Car snapshot is empty");
+    }
+    // Общее отображение только для чтения: чистые страницы page cache делят
+    // все процессы сервера. Контрольная точка заменяет файл через rename,
+    // поэтому отображённый старый файл остаётся целым, пока на него ссылаются.
+    size_t size = static_cast<size_t>(st.st_size);
+    int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+    flags |= MAP_POPULATE; // проверка контрольной суммы всё равно читает весь файл
+#endif
+    void* mapped = ::mmap(nullptr, size, PROT_READ, flags, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) throw std::runtime_error("Failed to map " + path);
+    ::madvise(mapped, size, MADV_WILLNEED);
+    std::shared_ptr<const void> mapping(mapped, [size](const void* data) {
+        ::munmap(const_cast<void*>(data), size);
+    });
+    return decode(std::string_view(static_cast<const char*>(mapped), size), std::move(mapping));
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include "car_store.hpp"
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+// Бинарный снимок хранилища автомобилей (data/cars.snapshot) — формат,
+// в котором каталог сохраняется в контрольных точках и читается при старте
+// вместо разбора cars.json.
+//
+// Заголовок: сигнатура "CARSNAP\0", версия формата, размер заголовка, число
+// строк, следующий id, размер и контрольная сумма данных. Данные — секции,
+// выровненные на 8 байт: столбцы фиксированной ширины (значения и маска
+// наличия), затем словари строковых столбцов и прочие поля (extras) в виде
+// таблицы смещений и подряд идущих байтов. Порядок байтов — родной для
+// машины: снимок не переносится между архитектурами. Индексы поиска не
+// сохраняются и строятся при чтении.
+//
+// Прочитанный с диска снимок не копируется: столбцы хранилища ссылаются на
+// отображённые страницы файла, поэтому поиск и просмотр идут прямо по ним,
+// а несколько процессов на одной машине держат одну копию в page cache.
+// В памяти процесса остаются словари, extras, id и индексы поиска.
+class CarSnapshot {
+public:
+    static constexpr uint32_t FORMAT_VERSION = 1;
+
+    static std::string encode(const CarStore& store);
+    // Ошибка std::runtime_error, если данные испорчены или другой версии.
+    // Если mapping владеет data, столбцы ссылаются на data, иначе копируются.
+    static CarStore decode(std::string_view data, std::shared_ptr<const void> mapping = nullptr);
+
+    // Запись через временный файл и rename
+    static bool write(const CarStore& store, const std::string& path);
+    // Чтение через mmap без копирования столбцов. nullopt, если файла нет;
+    // испорченный файл — std::runtime_error
+    static std::optional<CarStore> read(const std::string& path);
+};
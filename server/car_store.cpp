@@ -0,0 +1,373 @@
+#include "car_store.hpp"
+#include <algorithm>
+#include <limits>
+#include <string_view>
+
+namespace {
+
+// Целое значение JSON, помещающееся в int32 (дробные числа не подходят,
+// чтобы при сохранении 2020.0 не превратилось в 2020)
+bool as_int32(const json& value, int32_t& out) {
+    if (value.is_number_unsigned()) {
+        uint64_t v = value.get<uint64_t>();
+        if (v > static_cast<uint64_t>(std::numeric_limits<int32_t>::max())) return false;
+        out = static_cast<int32_t>(v);
+        return true;
+    }
+    if (value.is_number_integer()) {
+        int64_t v = value.get<int64_t>();
+        if (v < std::numeric_limits<int32_t>::min() || v > std::numeric_limits<int32_t>::max()) return false;
+        out = static_cast<int32_t>(v);
+        return true;
+    }
+    return false;
+}
+
+bool as_uint32(const json& value, uint32_t& out) {
+    if (!value.is_number_integer()) return false; // включает unsigned
+    if (value.is_number_unsigned()) {
+        uint64_t v = value.get<uint64_t>();
+        if (v > std::numeric_limits<uint32_t>::max()) return false;
+        out = static_cast<uint32_t>(v);
+        return true;
+    }
+    int64_t v = value.get<int64_t>();
+    if (v < 0 || v > static_cast<int64_t>(std::numeric_limits<uint32_t>::max())) return false;
+    out = static_cast<uint32_t>(v);
+    return true;
+}
+
+// Строка JSON в кавычках с тем же экранированием, что у json::dump()
+void append_string(std::string& out, std::string_view value) {
+    static const char HEX[] = "0123456789abcdef";
+    out += '"';
+    for (char c : value) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    out += "\\u00";
+                    out += HEX[(c >> 4) & 0xF];
+                    out += HEX[c & 0xF];
+                }
+                else {
+                    out += c;
+                }
+        }
+    }
+    out += '"';
+}
+
+template<class T>
+void push(Column<T>& column) {
+    column.values.push_back(T());
+    column.present.push_back(0);
+}
+
+template<class T>
+void erase_at(Column<T>& column, uint32_t row) {
+    column.values.erase(row);
+    column.present.erase(row);
+}
+
+template<class T>
+void clear_at(Column<T>& column, uint32_t row) {
+    column.values.set(row, T());
+    column.present.set(row, 0);
+}
+
+} // namespace
+
+uint32_t Dictionary::find(std::string_view value) const {
+    auto it = ids_.find(std::string(value));
+    return it == ids_.end() ? NONE : it->second;
+}
+
+uint32_t Dictionary::intern(const std::string& value) {
+    auto [it, inserted] = ids_.emplace(value, static_cast<uint32_t>(values_.size()));
+    if (inserted) values_.push_back(value);
+    return it->second;
+}
+
+int CarStore::string_column(std::string_view field) {
+    for (size_t i = 0; i < STRING_FIELDS.size(); ++i) {
+        if (STRING_FIELDS[i] == field) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+int CarStore::numeric_column(std::string_view field) {
+    for (size_t i = 0; i < NUMERIC_FIELDS.size(); ++i) {
+        if (NUMERIC_FIELDS[i] == field) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+bool CarStore::valid_id(const json& value) {
+    int32_t id = 0;
+    return as_int32(value, id);
+}
+
+CarStore CarStore::from_json(const json& cars) {
+    CarStore store;
+    if (!cars.is_array()) return store;
+    for (const auto& car : cars) {
+        store.push_empty_row();
+        uint32_t row = static_cast<uint32_t>(store.size() - 1);
+        store.set_row(row, car);
+        if (store.id_.has(row)) store.ids_.insert(store.id_.values[row], row);
+    }
+    store.index_.build(store);
+    return store;
+}
+
+json CarStore::to_json() const {
+    json cars = json::array();
+    for (uint32_t row = 0; row < size(); ++row) {
+        cars.push_back(to_json(row));
+    }
+    return cars;
+}
+
+json CarStore::to_json(uint32_t row) const {
+    const json& extras = extras_[row];
+    // Элемент массива, который не является объектом, хранится как есть
+    if (!extras.is_null() && !extras.is_object()) return extras;
+
+    json car = extras.is_object() ? extras : json::object();
+    if (id_.has(row)) car["id"] = id_.values[row];
+    for (size_t i = 0; i < strings_.size(); ++i) {
+        if (strings_[i].has(row)) {
+            car[std::string(STRING_FIELDS[i])] = dictionaries_[i].value(strings_[i].values[row]);
+        }
+    }
+    if (year_.has(row)) car["year"] = year_.values[row];
+    if (price_usd_.has(row)) car["price_usd"] = price_usd_.values[row];
+    if (horsepower_.has(row)) car["horsepower"] = horsepower_.values[row];
+    if (engine_volume_.has(row)) car["engine_volume"] = engine_volume_.values[row];
+    return car;
+}
+
+CarStore::Projection::Projection(const std::vector<std::string>& fields) {
+    std::vector<std::string> names = fields;
+    std::sort(names.begin(), names.end());
+    names.erase(std::unique(names.begin(), names.end()), names.end());
+    for (auto& name : names) {
+        Field field;
+        append_string(field.key, name);
+        field.key += ':';
+        field.string_column = string_column(name);
+        field.numeric_column = numeric_column(name);
+        field.name = std::move(name);
+        fields_.push_back(std::move(field));
+    }
+}
+
+void CarStore::write_json(uint32_t row, const Projection& projection, std::string& out) const {
+    const json& extras = extras_[row];
+    if (!extras.is_null() && !extras.is_object()) {
+        out += extras.dump();
+        return;
+    }
+
+    out += '{';
+    bool first = true;
+    for (const auto& field : projection.fields_) {
+        size_t mark = out.size();
+        if (!first) out += ',';
+        out += field.key;
+
+        bool written = true;
+        if (const json* value = extra(row, field.name)) {
+            out += value->dump();
+        }
+        else if (field.string_column >= 0 && strings_[field.string_column].has(row)) {
+            append_string(out, dictionaries_[field.string_column].value(strings_[field.string_column].values[row]));
+        }
+        else if (field.name == "id" && id_.has(row)) {
+            out += std::to_string(id_.values[row]);
+        }
+        else if (field.numeric_column == Year && year_.has(row)) {
+            out += std::to_string(year_.values[row]);
+        }
+        else if (field.numeric_column == PriceUsd && price_usd_.has(row)) {
+            out += std::to_string(price_usd_.values[row]);
+        }
+        else if (field.numeric_column == Horsepower && horsepower_.has(row)) {
+            out += std::to_string(horsepower_.values[row]);
+        }
+        else if (field.numeric_column == EngineVolume && engine_volume_.has(row)) {
+            // Формат дробных чисел — как у json::dump()
+            out += json(engine_volume_.values[row]).dump();
+        }
+        else {
+            written = false;
+        }
+
+        if (written) first = false;
+        else out.resize(mark); // поля у строки нет
+    }
+    out += '}';
+}
+
+void CarStore::append(const json& car) {
+    push_empty_row();
+    uint32_t row = static_cast<uint32_t>(size() - 1);
+    set_row(row, car);
+    if (!bulk_) index_.append(*this, row);
+    if (id_.has(row)) ids_.insert(id_.values[row], row);
+}
+
+void CarStore::update(uint32_t row, const json& car) {
+    if (!bulk_) index_.erase(*this, row);
+    if (id_.has(row) && ids_.find(id_.values[row]) == row) ids_.erase(id_.values[row]);
+    clear_row(row);
+    set_row(row, car);
+    if (!bulk_) index_.insert(*this, row);
+    if (id_.has(row)) ids_.insert(id_.values[row], row);
+}
+
+void CarStore::remove(uint32_t row) {
+    if (!bulk_) index_.remove(*this, row);
+    if (id_.has(row) && ids_.find(id_.values[row]) == row) ids_.erase(id_.values[row]);
+    ids_.shift_after(row);
+    erase_at(id_, row);
+    erase_at(year_, row);
+    erase_at(price_usd_, row);
+    erase_at(horsepower_, row);
+    erase_at(engine_volume_, row);
+    for (auto& column : strings_) erase_at(column, row);
+    extras_.erase(extras_.begin() + row);
+}
+
+bool CarStore::string_id(size_t column, uint32_t row, uint32_t& id) const {
+    if (!strings_[column].has(row)) return false;
+    id = strings_[column].values[row];
+    return true;
+}
+
+bool CarStore::numeric(size_t column, uint32_t row, double& value) const {
+    switch (column) {
+        case Year:
+            if (!year_.has(row)) return false;
+            value = year_.values[row];
+            return true;
+        case PriceUsd:
+            if (!price_usd_.has(row)) return false;
+            value = price_usd_.values[row];
+            return true;
+        case Horsepower:
+            if (!horsepower_.has(row)) return false;
+            value = horsepower_.values[row];
+            return true;
+        case EngineVolume:
+            if (!engine_volume_.has(row)) return false;
+            value = engine_volume_.values[row];
+            return true;
+    }
+    return false;
+}
+
+const json* CarStore::extra(uint32_t row, std::string_view field) const {
+    const json& extras = extras_[row];
+    if (!extras.is_object()) return nullptr;
+    auto it = extras.find(field);
+    return it == extras.end() ? nullptr : &*it;
+}
+
+bool CarStore::value(uint32_t row, std::string_view field, json& out) const {
+    if (const json* value = extra(row, field)) {
+        out = *value;
+        return true;
+    }
+    if (field == "id") {
+        if (!id_.has(row)) return false;
+        out = id_.values[row];
+        return true;
+    }
+    int column = string_column(field);
+    uint32_t id;
+    if (column >= 0 && string_id(column, row, id)) {
+        out = dictionaries_[column].value(id);
+        return true;
+    }
+    column = numeric_column(field);
+    if (column < 0) return false;
+    switch (column) {
+        case Year: if (!year_.has(row)) return false; out = year_.values[row]; return true;
+        case PriceUsd: if (!price_usd_.has(row)) return false; out = price_usd_.values[row]; return true;
+        case Horsepower: if (!horsepower_.has(row)) return false; out = horsepower_.values[row]; return true;
+        case EngineVolume: if (!engine_volume_.has(row)) return false; out = engine_volume_.values[row]; return true;
+    }
+    return false;
+}
+
+void CarStore::push_empty_row() {
+    push(id_);
+    push(year_);
+    push(price_usd_);
+    push(horsepower_);
+    push(engine_volume_);
+    for (auto& column : strings_) push(column);
+    extras_.emplace_back();
+}
+
+void CarStore::clear_row(uint32_t row) {
+    clear_at(id_, row);
+    clear_at(year_, row);
+    clear_at(price_usd_, row);
+    clear_at(horsepower_, row);
+    clear_at(engine_volume_, row);
+    for (auto& column : strings_) clear_at(column, row);
+    extras_[row] = nullptr;
+}
+
+// Раскладка объекта по столбцам. Значение попадает в столбец, только если
+// его тип совпадает с типом столбца, иначе остаётся в extras как есть.
+void CarStore::set_row(uint32_t row, const json& car) {
+    if (!car.is_object()) {
+        extras_[row] = car;
+        return;
+    }
+
+    json extras = json::object();
+    for (auto& [key, value] : car.items()) {
+        int32_t int_value;
+        uint32_t uint_value;
+        if (key == "id" && as_int32(value, int_value)) {
+            id_.values.set(row, int_value);
+            id_.present.set(row, 1);
+            continue;
+        }
+        int column = string_column(key);
+        if (column >= 0 && value.is_string()) {
+            strings_[column].values.set(row, dictionaries_[column].intern(value.get<std::string>()));
+            strings_[column].present.set(row, 1);
+            continue;
+        }
+        switch (numeric_column(key)) {
+            case Year:
+                if (as_int32(value, int_value)) { year_.values.set(row, int_value); year_.present.set(row, 1); continue; }
+                break;
+            case PriceUsd:
+                if (as_uint32(value, uint_value)) { price_usd_.values.set(row, uint_value); price_usd_.present.set(row, 1); continue; }
+                break;
+            case Horsepower:
+                if (as_int32(value, int_value)) { horsepower_.values.set(row, int_value); horsepower_.present.set(row, 1); continue; }
+                break;
+            case EngineVolume:
+                if (value.is_number_float()) { engine_volume_.values.set(row, value.get<double>()); engine_volume_.present.set(row, 1); continue; }
+                break;
+            default:
+                break;
+        }
+        extras[key] = value;
+    }
+    if (!extras.empty()) extras_[row] = std::move(extras);
+}
@@ -0,0 +1,196 @@
+#pragma once
+#include "../common/json.hpp"
+#include "car_index.hpp"
+#include "id_index.hpp"
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+using json = nlohmann::json;
+
+// Словарь строковых значений столбца: строка -> номер. Номера не переиспользуются,
+// поэтому остаются верными во всех копиях хранилища.
+class Dictionary {
+public:
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    uint32_t find(std::string_view value) const;
+    uint32_t intern(const std::string& value);
+    const std::string& value(uint32_t id) const { return values_[id]; }
+    size_t size() const { return values_.size(); }
+
+private:
+    std::vector<std::string> values_;
+    std::unordered_map<std::string, uint32_t> ids_;
+};
+
+// Массив значений столбца: собственный вектор или участок снимка,
+// отображённого в память (только чтение, страницы page cache общие для всех
+// процессов сервера). Первое изменение копирует участок в свой вектор, так
+// что копии хранилища, которые не меняют столбец, не тратят на него память.
+template<class T>
+class ColumnArray {
+public:
+    using value_type = T;
+
+    ColumnArray() = default;
+    // mapping держит отображение живым, пока на него ссылается хоть один массив
+    ColumnArray(std::shared_ptr<const void> mapping, const T* data, size_t size)
+        : mapping_(std::move(mapping)), mapped_(data), size_(size) {}
+
+    const T* data() const { return mapping_ ? mapped_ : owned_.data(); }
+    size_t size() const { return mapping_ ? size_ : owned_.size(); }
+    const T& operator[](size_t i) const { return data()[i]; }
+    const T* begin() const { return data(); }
+    const T* end() const { return data() + size(); }
+    // Значения лежат в отображённом файле, а не в памяти процесса
+    bool mapped() const { return mapping_ != nullptr; }
+
+    void set(size_t i, T value) { own()[i] = value; }
+    void push_back(T value) { own().push_back(value); }
+    void erase(size_t i) { own().erase(owned_.begin() + i); }
+    void assign(const T* data, size_t size) {
+        mapping_.reset();
+        owned_.assign(data, data + size);
+    }
+
+private:
+    std::vector<T>& own() {
+        if (mapping_) {
+            owned_.assign(mapped_, mapped_ + size_);
+            mapping_.reset();
+        }
+        return owned_;
+    }
+
+    std::shared_ptr<const void> mapping_;
+    const T* mapped_ = nullptr;
+    size_t size_ = 0;
+    std::vector<T> owned_;
+};
+
+// Типизированный столбец с маской наличия значения
+template<class T>
+struct Column {
+    ColumnArray<T> values;
+    ColumnArray<uint8_t> present; // 1 — значение есть и хранится в values
+
+    bool has(uint32_t row) const { return present[row] != 0; }
+};
+
+// Колоночное хранилище автомобилей (структура массивов). Известные поля
+// хранятся в типизированных столбцах, строковые — номерами словаря, поэтому
+// просмотр условия по одному полю идёт по непрерывному массиву. Остальные
+// поля и значения неожиданного типа (например, "year": "2019") хранятся в
+// extras и сохраняются без изменений. JSON строится только для строк,
+// попавших в ответ.
+class CarStore {
+public:
+    static constexpr std::array<std::string_view, CarIndex::STRING_COLUMNS> STRING_FIELDS = {
+        "brand", "model", "fuel_type", "steering_wheel", "country"
+    };
+    static constexpr std::array<std::string_view, CarIndex::NUMERIC_COLUMNS> NUMERIC_FIELDS = {
+        "year", "price_usd", "horsepower", "engine_volume"
+    };
+    enum NumericColumn { Year, PriceUsd, Horsepower, EngineVolume };
+
+    // Номер столбца по имени поля, -1 если поле не типизировано
+    static int string_column(std::string_view field);
+    static int numeric_column(std::string_view field);
+    // Подходит ли значение для столбца id: целое в пределах int32
+    static bool valid_id(const json& value);
+
+    // Набор полей для вывода (параметр fields=), разобранный один раз на запрос
+    class Projection {
+    public:
+        explicit Projection(const std::vector<std::string>& fields);
+
+    private:
+        friend class CarStore;
+        struct Field {
+            std::string name;
+            std::string key; // "name": с экранированием
+            int string_column = -1;
+            int numeric_column = -1;
+        };
+        std::vector<Field> fields_; // по алфавиту, как ключи в json::dump()
+    };
+
+    static CarStore from_json(const json& cars);
+    json to_json() const;
+    json to_json(uint32_t row) const;
+    // Объект строки только с полями projection — сразу текстом в out, без
+    // построения json; совпадает с dump() объекта to_json(row) без прочих полей
+    void write_json(uint32_t row, const Projection& projection, std::string& out) const;
+
+    size_t size() const { return extras_.size(); }
+
+    // Изменения; индекс обновляется вместе с данными
+    void append(const json& car);
+    void update(uint32_t row, const json& car);
+    void remove(uint32_t row);
+
+    // Пакетное изменение: пока объект жив, append/update/remove не обновляют
+    // индексы поиска, а при его разрушении индексы строятся заново один раз —
+    // O(n) на всю пачку вместо вставки в упорядоченные индексы на каждую
+    // строку. Поиск по id (find_id) работает и внутри пачки.
+    class BulkUpdate {
+    public:
+        explicit BulkUpdate(CarStore& store) : store_(store) { store_.bulk_ = true; }
+        ~BulkUpdate() {
+            store_.bulk_ = false;
+            store_.index_.build(store_);
+        }
+        BulkUpdate(const BulkUpdate&) = delete;
+        BulkUpdate& operator=(const BulkUpdate&) = delete;
+
+    private:
+        CarStore& store_;
+    };
+
+    // Позиция автомобиля с заданным id — по хеш-индексу
+    std::optional<uint32_t> find_id(int id) const { return ids_.find(id); }
+    // id для нового автомобиля: больше всех id, которые были в хранилище
+    int allocate_id() { return ids_.allocate(); }
+
+    // Значения полей строки
+    bool string_id(size_t column, uint32_t row, uint32_t& id) const;
+    bool numeric(size_t column, uint32_t row, double& value) const;
+    // Поле из extras (нетипизированное значение), nullptr если его нет
+    const json* extra(uint32_t row, std::string_view field) const;
+    // Значение любого поля в виде JSON
+    bool value(uint32_t row, std::string_view field, json& out) const;
+
+    const Dictionary& dictionary(size_t column) const { return dictionaries_[column]; }
+    const Column<uint32_t>& string_values(size_t column) const { return strings_[column]; }
+    const Column<int32_t>& years() const { return year_; }
+    const Column<uint32_t>& prices() const { return price_usd_; }
+    const Column<int32_t>& horsepowers() const { return horsepower_; }
+    const Column<double>& engine_volumes() const { return engine_volume_; }
+
+    const CarIndex& index() const { return index_; }
+
+private:
+    friend class CarSnapshot;
+
+    void push_empty_row();
+    void clear_row(uint32_t row);
+    void set_row(uint32_t row, const json& car);
+
+    Column<int32_t> id_;
+    Column<int32_t> year_;
+    Column<uint32_t> price_usd_;
+    Column<int32_t> horsepower_;
+    Column<double> engine_volume_;
+    std::array<Column<uint32_t>, CarIndex::STRING_COLUMNS> strings_;
+    std::array<Dictionary, CarIndex::STRING_COLUMNS> dictionaries_;
+    std::vector<json> extras_; // объект с прочими полями или null
+    CarIndex index_;
+    IdIndex ids_;
+    bool bulk_ = false; // идёт BulkUpdate: индекс перестроится в конце
+};
@@ -0,0 +1,74 @@
+#include "car_suggest.hpp"
+#include <algorithm>
+#include <string>
+#include <tuple>
+
+namespace {
+
+struct Suggestion {
+    size_t column;
+    uint32_t id;
+    uint64_t count;
+    int distance;
+};
+
+// Допустимое число опечаток по длине запроса в символах
+int max_typos(std::string_view query) {
+    size_t length = static_cast<size_t>(std::count_if(query.begin(), query.end(),
+        [](char c) { return (static_cast<unsigned char>(c) & 0xC0) != 0x80; }));
+    return length <= 3 ? 0 : length <= 6 ? 1 : 2;
+}
+
+} // namespace
+
+json car_suggestions(const CarStore& store, std::string_view query, const std::vector<size_t>& columns,
+                     const RoaringBitmap* selection, size_t limit) {
+    const std::string folded = fold_case(query);
+    const CarIndex& index = store.index();
+
+    auto count = [&](size_t column, uint32_t id) {
+        const RoaringBitmap& postings = index.find(column, id);
+        return selection ? RoaringBitmap::and_cardinality(*selection, postings) : postings.cardinality();
+    };
+
+    std::vector<Suggestion> prefixed;
+    for (size_t column : columns) {
+        for (uint32_t id : index.text(column).with_prefix(folded)) {
+            uint64_t cars = count(column, id);
+            if (cars > 0) prefixed.push_back({column, id, cars, 0});
+        }
+    }
+    std::sort(prefixed.begin(), prefixed.end(), [&](const Suggestion& a, const Suggestion& b) {
+        if (a.count != b.count) return a.count > b.count;
+        return store.dictionary(a.column).value(a.id) < store.dictionary(b.column).value(b.id);
+    });
+
+    // Опечатки ищутся, только если точных начал не хватило на весь список
+    std::vector<Suggestion> fuzzy;
+    int typos = max_typos(folded);
+    if (prefixed.size() < limit && typos > 0) {
+        for (size_t column : columns) {
+            for (const auto& [id, distance] : index.text(column).fuzzy_prefix(folded, typos)) {
+                if (distance == 0) continue; // уже среди начал
+                uint64_t cars = count(column, id);
+                if (cars > 0) fuzzy.push_back({column, id, cars, distance});
+            }
+        }
+        std::sort(fuzzy.begin(), fuzzy.end(), [](const Suggestion& a, const Suggestion& b) {
+            return std::tie(a.distance, b.count, a.column, a.id) < std::tie(b.distance, a.count, b.column, b.id);
+        });
+    }
+
+    json result = json::array();
+    for (const auto* group : {&prefixed, &fuzzy}) {
+        for (const auto& suggestion : *group) {
+            if (result.size() >= limit) return result;
+            result.push_back({
+                {"field", std::string(CarStore::STRING_FIELDS[suggestion.column])},
+                {"value", store.dictionary(suggestion.column).value(suggestion.id)},
+                {"count", suggestion.count}
+            });
+        }
+    }
+    return result;
+}
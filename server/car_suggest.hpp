@@ -0,0 +1,19 @@
+#pragma once
+#include "car_store.hpp"
+#include "../common/json.hpp"
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+using json = nlohmann::json;
+
+// Подсказки автодополнения по строковым столбцам columns:
+// [{"field": "model", "value": "Land Cruiser Prado", "count": 1}, ...].
+// Сначала значения, у которых запрос — начало значения или его слова (без
+// учёта регистра), по убыванию числа автомобилей; затем, если места хватает,
+// значения с опечатками в запросе — по числу правок (до 1 правки
+// для запросов из 4-6 символов, до 2 — для более длинных).
+// selection — автомобили, среди которых считается число (nullptr — весь
+// каталог); значения без автомобилей не предлагаются.
+json car_suggestions(const CarStore& store, std::string_view query, const std::vector<size_t>& columns,
+                     const RoaringBitmap* selection, size_t limit);
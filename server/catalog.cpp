@@ -0,0 +1,583 @@
+#include "catalog.hpp"
+#include "car_snapshot.hpp"
+#include "../common/logger.hpp"
+#include "../common/utils.hpp"
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <optional>
+#include <stdexcept>
+
+namespace {
+
+// Загрузка JSON-файла; при ошибке возвращается fallback
+json load_json_file(const std::string& path, const json& fallback) {
+    std::string content = read_file(path);
+    try {
+        return json::parse(content);
+    } catch (...) {
+        std::cerr << "Ошибка парсинга " << path << "\n";
+        Logger::log_error("Failed to parse " + path);
+        return fallback;
+    }
+}
+
+const char* dataset_name(Dataset dataset) {
+    switch (dataset) {
+        case Dataset::Cars: return "cars";
+        case Dataset::Cities: return "cities";
+        case Dataset::Documents: break;
+    }
+    return "documents";
+}
+
+// Запись журнала: новое состояние записи с id или её удаление (record == nullptr)
+json wal_entry(Dataset dataset, int id, const json* record) {
+    json entry = {{"dataset", dataset_name(dataset)}, {"id", id}};
+    if (record) entry["record"] = *record;
+    else entry["deleted"] = true;
+    return entry;
+}
+
+// Применение записи журнала к автомобилям
+void replay(CarStore& cars, int id, const json& entry) {
+    auto row = cars.find_id(id);
+    if (entry.contains("record")) {
+        if (row) cars.update(*row, entry["record"]);
+        else cars.append(entry["record"]);
+    }
+    else if (row) {
+        cars.remove(*row);
+    }
+}
+
+// Применение записи журнала к городам или документам
+void replay(json& records, IdIndex& ids, int id, const json& entry) {
+    auto slot = ids.find(id);
+    if (entry.contains("record")) {
+        if (slot) {
+            records[*slot] = entry["record"];
+        }
+        else {
+            ids.insert(id, static_cast<uint32_t>(records.size()));
+            records.push_back(entry["record"]);
+        }
+    }
+    else if (slot) {
+        records.erase(records.begin() + *slot);
+        ids.erase(id);
+        ids.shift_after(*slot);
+    }
+}
+
+// Автомобили: из бинарного снимка, а если его нет, он испорчен или
+// cars.json изменён позже него — импортом cars.json (imported = true)
+CarStore load_cars(const std::string& data_dir, bool& imported) {
+    std::string json_path = data_dir + "/cars.json";
+    std::string snapshot_path = data_dir + "/cars.snapshot";
+    std::error_code json_error, snapshot_error;
+    auto json_time = std::filesystem::last_write_time(json_path, json_error);
+    auto snapshot_time = std::filesystem::last_write_time(snapshot_path, snapshot_error);
+
+    imported = true;
+    if (!snapshot_error && (json_error || json_time <= snapshot_time)) {
+        try {
+            if (auto cars = CarSnapshot::read(snapshot_path)) {
+                imported = false;
+                return std::move(*cars);
+            }
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Ошибка чтения " << snapshot_path << ": " << e.what() << "\n";
+            Logger::log_error("Failed to read " + snapshot_path + ": " + e.what());
+        }
+    }
+    // Автомобили раскладываются по типизированным столбцам один раз при загрузке
+    return CarStore::from_json(load_json_file(json_path, json::array()));
+}
+
+// Снимок автомобилей, заново прочитанный из только что записанного файла:
+// его столбцы отображены из файла и общие для процессов, а не лежат в
+// памяти этого процесса. nullopt, если отобразить файл не удалось
+std::optional<CarStore> map_cars(const std::string& path) {
+    try {
+        return CarSnapshot::read(path);
+    }
+    catch (const std::exception& e) {
+        Logger::log_error("Failed to map " + path + ": " + e.what());
+        return std::nullopt;
+    }
+}
+
+// Автомобили, изменённые при загрузке (импорт или журнал), сразу сохраняются
+// в снимок и читаются из него заново. false, если снимок записать не удалось
+bool remap_cars(const std::string& data_dir, CarStore& cars) {
+    std::string path = data_dir + "/cars.snapshot";
+    if (!CarSnapshot::write(cars, path)) {
+        Logger::log_error("Failed to save " + path);
+        return false;
+    }
+    if (auto mapped = map_cars(path)) cars = std::move(*mapped);
+    return true;
+}
+
+// Индекс записей по целому полю "id"; записи без id в индекс не попадают
+IdIndex index_records(const json& records) {
+    IdIndex ids;
+    for (uint32_t slot = 0; slot < records.size(); ++slot) {
+        const json& record = records[slot];
+        if (record.is_object() && record.contains("id") && record["id"].is_number_integer()) {
+            ids.insert(record["id"].get<int32_t>(), slot);
+        }
+    }
+    return ids;
+}
+
+// Проверка перечитанного набора: массив объектов, id (если есть) целые и
+// не повторяются. Индекс по id строится заодно; error — причина отказа
+bool check_records(const json& records, IdIndex& ids, std::string& error) {
+    if (!records.is_array()) {
+        error = "records are not an array";
+        return false;
+    }
+    for (uint32_t slot = 0; slot < records.size(); ++slot) {
+        const json& record = records[slot];
+        if (!record.is_object()) {
+            error = "record " + std::to_string(slot) + " is not an object";
+            return false;
+        }
+        if (!record.contains("id")) continue;
+        if (!record["id"].is_number_integer() || !ids.insert(record["id"].get<int32_t>(), slot)) {
+            error = "record " + std::to_string(slot) + " has an invalid or duplicate id";
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+Catalog& Catalog::instance() {
+    static Catalog catalog;
+    return catalog;
+}
+
+Catalog::Catalog() {
+    auto empty = std::make_shared<CatalogSnapshot>();
+    empty->cars = std::make_shared<const CarStore>();
+    empty->cities = std::make_shared<const json>(json::array());
+    empty->documents = std::make_shared<const json>(json{{"documents", json::array()}});
+    empty->city_ids = std::make_shared<const IdIndex>();
+    empty->document_ids = std::make_shared<const IdIndex>();
+    current_ = std::move(empty);
+}
+
+Catalog::~Catalog() {
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        stopping_ = true;
+    }
+    queue_ready_.notify_all();
+    if (writer_.joinable()) writer_.join();
+}
+
+void Catalog::load(const std::string& data_dir) {
+    auto started = std::chrono::steady_clock::now();
+    bool imported = false;
+    CarStore cars = load_cars(data_dir, imported);
+    json cities = load_json_file(data_dir + "/cities.json", json::array());
+    if (!cities.is_array()) {
+        cities = json::array();
+    }
+    IdIndex city_ids = index_records(cities);
+
+    json documents = load_json_file(data_dir + "/documents.json", json::object());
+    if (!documents.is_object()) {
+        documents = json::object();
+    }
+    if (!documents.contains("documents")) {
+        documents["documents"] = json::array();
+    }
+    IdIndex document_ids = index_records(documents["documents"]);
+
+    // Изменения после последней контрольной точки
+    std::vector<json> entries = WriteAheadLog::read(data_dir + "/catalog.wal");
+    bool cars_changed = imported;
+    for (const auto& entry : entries) {
+        if (!entry.is_object() || !entry.contains("id") || !entry["id"].is_number_integer()) continue;
+        int id = entry["id"].get<int>();
+        std::string dataset = entry.value("dataset", "");
+        if (dataset == "cars") {
+            replay(cars, id, entry);
+            cars_changed = true;
+        }
+        else if (dataset == "cities") replay(cities, city_ids, id, entry);
+        else if (dataset == "documents") replay(documents["documents"], document_ids, id, entry);
+    }
+
+    bool cars_saved = cars_changed && remap_cars(data_dir, cars);
+
+    auto snapshot = std::make_shared<CatalogSnapshot>();
+    snapshot->cars = std::make_shared<const CarStore>(std::move(cars));
+    snapshot->cities = std::make_shared<const json>(std::move(cities));
+    snapshot->city_ids = std::make_shared<const IdIndex>(std::move(city_ids));
+    snapshot->documents = std::make_shared<const json>(std::move(documents));
+    snapshot->document_ids = std::make_shared<const IdIndex>(std::move(document_ids));
+
+    Logger::log_info("Catalog loaded: " + std::to_string(snapshot->cars->size()) + " cars, " +
+                     std::to_string(snapshot->cities->size()) + " cities, " +
+                     std::to_string((*snapshot->documents)["documents"].size()) + " documents, " +
+                     std::to_string(entries.size()) + " journal records replayed" +
+                     (imported ? ", cars imported from cars.json" : "") + " in " +
+                     std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(
+                         std::chrono::steady_clock::now() - started).count()) + " ms");
+
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    data_dir_ = data_dir;
+    on_disk_[static_cast<int>(Dataset::Cities)] = snapshot->cities;
+    on_disk_[static_cast<int>(Dataset::Documents)] = snapshot->documents;
+    uint64_t version = version_.load(std::memory_order_relaxed) + 1;
+    snapshot->cars_version = snapshot->cities_version = snapshot->documents_version = version;
+    publish(std::move(snapshot));
+
+    // Применённый журнал сразу переносится в файлы (автомобили уже в снимке);
+    // заодно отбрасывается недописанный хвост, к которому нельзя дописывать
+    // новые записи
+    wal_ = std::make_unique<WriteAheadLog>(data_dir + "/catalog.wal");
+    std::fill(std::begin(dirty_), std::end(dirty_), !entries.empty());
+    dirty_[static_cast<int>(Dataset::Cars)] = cars_changed && !cars_saved;
+    write_checkpoint();
+}
+
+bool Catalog::reload(Dataset dataset, std::chrono::steady_clock::time_point changed_at) {
+    auto prepared = prepare_reload(dataset, changed_at);
+    return prepared && apply_reload(*prepared);
+}
+
+std::optional<Catalog::PreparedReload> Catalog::prepare_reload(Dataset dataset,
+                                                               std::chrono::steady_clock::time_point changed_at) {
+    if (dataset == Dataset::Cars) throw std::logic_error("Cars are imported from cars.json only at load");
+    PreparedReload prepared{dataset, changed_at, {}, nullptr, std::make_shared<IdIndex>(), nullptr};
+    {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        prepared.path = path_for(dataset);
+        prepared.on_disk = on_disk_[static_cast<int>(dataset)];
+    }
+    const std::string& path = prepared.path;
+
+    // Разбор и проверка — без блокировок, читатели и запись не ждут
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        Logger::log_error("Failed to reload " + path + ": file not found");
+        return std::nullopt;
+    }
+    auto data = std::make_shared<json>();
+    try {
+        *data = json::parse(file);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Ошибка парсинга " << path << ", используются прежние данные\n";
+        Logger::log_error("Failed to reload " + path + ": " + e.what());
+        return std::nullopt;
+    }
+    // Событие от собственной контрольной точки или правка без изменений
+    if (prepared.on_disk && *data == *prepared.on_disk) return std::nullopt;
+
+    std::string error;
+    bool valid = dataset == Dataset::Cities || data->is_object();
+    if (!valid) {
+        error = "documents file is not an object";
+    }
+    else {
+        if (dataset == Dataset::Documents && !data->contains("documents")) (*data)["documents"] = json::array();
+        valid = check_records(records_of(*data, dataset), *prepared.ids, error);
+    }
+    if (!valid) {
+        std::cerr << "Ошибка в " << path << ": " << error << ", используются прежние данные\n";
+        Logger::log_error("Failed to reload " + path + ": " + error);
+        return std::nullopt;
+    }
+    prepared.data = std::move(data);
+    return prepared;
+}
+
+bool Catalog::apply_reload(const PreparedReload& prepared) {
+    const int i = static_cast<int>(prepared.dataset);
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    // Пока файл разбирался, каталог сам переписал его контрольной точкой:
+    // прочитано могло быть его же содержимое, которое старше данных в
+    // памяти и журнале. Настоящая правка поверх придёт новым событием.
+    if (on_disk_[i] != prepared.on_disk) {
+        Logger::log_info("Reload of " + prepared.path + " skipped: file was rewritten by a checkpoint");
+        return false;
+    }
+
+    auto snapshot = std::make_shared<CatalogSnapshot>(*std::atomic_load(&current_));
+    uint64_t version = version_.load(std::memory_order_relaxed) + 1;
+    if (prepared.dataset == Dataset::Cities) {
+        snapshot->cities = prepared.data;
+        snapshot->city_ids = prepared.ids;
+        snapshot->cities_version = version;
+    }
+    else {
+        snapshot->documents = prepared.data;
+        snapshot->document_ids = prepared.ids;
+        snapshot->documents_version = version;
+    }
+    publish(std::move(snapshot));
+    on_disk_[i] = prepared.data;
+    dirty_[i] = false;
+    // Записи журнала о прежней версии набора при следующей загрузке
+    // испортили бы исправленный файл — журнал переносится в файлы сразу
+    write_checkpoint();
+
+    Logger::log_info("Reloaded " + prepared.path + ": " +
+                     std::to_string(records_of(*prepared.data, prepared.dataset).size()) + " records, " +
+                     std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(
+                         std::chrono::steady_clock::now() - prepared.changed_at).count()) + " ms after change");
+    return true;
+}
+
+std::shared_ptr<const CatalogSnapshot> Catalog::snapshot() const {
+    // Ссылку держит только вызывающий: без кэша в потоках старый снимок (и
+    // отображённый файл его автомобилей) освобождается сразу после последнего
+    // запроса, который его читал
+    return std::atomic_load(&current_);
+}
+
+const std::shared_ptr<const json>& Catalog::dataset_of(const CatalogSnapshot& snapshot, Dataset dataset) {
+    switch (dataset) {
+        case Dataset::Cars: throw std::logic_error("Cars are modified with Catalog::modify_cars");
+        case Dataset::Cities: return snapshot.cities;
+        case Dataset::Documents: break;
+    }
+    return snapshot.documents;
+}
+
+const std::shared_ptr<const IdIndex>& Catalog::ids_of(const CatalogSnapshot& snapshot, Dataset dataset) {
+    switch (dataset) {
+        case Dataset::Cars: throw std::logic_error("Cars are modified with Catalog::modify_cars");
+        case Dataset::Cities: return snapshot.city_ids;
+        case Dataset::Documents: break;
+    }
+    return snapshot.document_ids;
+}
+
+json& Catalog::records_of(json& data, Dataset dataset) {
+    return dataset == Dataset::Documents ? data["documents"] : data;
+}
+
+std::string Catalog::path_for(Dataset dataset) const {
+    switch (dataset) {
+        case Dataset::Cars: return data_dir_ + "/cars.json";
+        case Dataset::Cities: return data_dir_ + "/cities.json";
+        case Dataset::Documents: return data_dir_ + "/documents.json";
+    }
+    return {};
+}
+
+// Сохранение набора данных: запись во временный файл и атомарная замена
+bool Catalog::save(Dataset dataset, const json& data) const {
+    std::string path = path_for(dataset);
+    // Форматируем с отступами для удобства чтения
+    if (!write_file_atomically(path, data.dump(4))) {
+        Logger::log_error("Failed to save " + path);
+        return false;
+    }
+    return true;
+}
+
+// Автомобили сохраняются бинарным снимком; cars.json остаётся форматом импорта
+bool Catalog::save_cars(const CarStore& cars) const {
+    std::string path = data_dir_ + "/cars.snapshot";
+    if (!CarSnapshot::write(cars, path)) {
+        Logger::log_error("Failed to save " + path);
+        return false;
+    }
+    return true;
+}
+
+WriteAheadLog& Catalog::wal() {
+    if (!wal_) wal_ = std::make_unique<WriteAheadLog>(data_dir_ + "/catalog.wal");
+    return *wal_;
+}
+
+CarStore& Catalog::WriteBatch::cars() {
+    if (!cars_) cars_ = std::make_shared<CarStore>(*base_->cars);
+    return *cars_;
+}
+
+json& Catalog::WriteBatch::records(Dataset dataset) {
+    auto& data = data_[static_cast<int>(dataset)];
+    if (!data) data = std::make_shared<json>(*dataset_of(*base_, dataset));
+    return records_of(*data, dataset);
+}
+
+IdIndex& Catalog::WriteBatch::ids(Dataset dataset) {
+    auto& ids = ids_[static_cast<int>(dataset)];
+    if (!ids) ids = std::make_shared<IdIndex>(*ids_of(*base_, dataset));
+    return *ids;
+}
+
+void Catalog::WriteBatch::log(Dataset dataset, const ChangedIds& changed) {
+    for (int id : changed) {
+        if (dataset == Dataset::Cars) {
+            auto row = cars_->find_id(id);
+            json record = row ? cars_->to_json(*row) : json();
+            entries_.push_back(wal_entry(dataset, id, row ? &record : nullptr));
+        }
+        else {
+            auto slot = ids(dataset).find(id);
+            entries_.push_back(wal_entry(dataset, id, slot ? &records(dataset)[*slot] : nullptr));
+        }
+    }
+    changed_[static_cast<int>(dataset)] = true;
+}
+
+std::shared_ptr<CatalogSnapshot> Catalog::WriteBatch::snapshot(uint64_t version) const {
+    auto snapshot = std::make_shared<CatalogSnapshot>(*base_);
+    if (changed(Dataset::Cars)) {
+        snapshot->cars = cars_;
+        snapshot->cars_version = version;
+    }
+    if (changed(Dataset::Cities)) {
+        snapshot->cities = data_[static_cast<int>(Dataset::Cities)];
+        snapshot->city_ids = ids_[static_cast<int>(Dataset::Cities)];
+        snapshot->cities_version = version;
+    }
+    if (changed(Dataset::Documents)) {
+        snapshot->documents = data_[static_cast<int>(Dataset::Documents)];
+        snapshot->document_ids = ids_[static_cast<int>(Dataset::Documents)];
+        snapshot->documents_version = version;
+    }
+    return snapshot;
+}
+
+bool Catalog::submit(std::function<bool(WriteBatch&)> apply) {
+    Mutation mutation{std::move(apply), {}};
+    std::future<bool> done = mutation.done.get_future();
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        if (!writer_.joinable()) writer_ = std::thread([this] { run_writer(); });
+        queue_.push_back(std::move(mutation));
+    }
+    queue_ready_.notify_one();
+    return done.get();
+}
+
+void Catalog::run_writer() {
+    std::unique_lock<std::mutex> lock(queue_mutex_);
+    while (true) {
+        queue_ready_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+        if (queue_.empty()) return;
+
+        // Изменения, пришедшие следом, попадают в ту же пачку и тот же fsync
+        queue_ready_.wait_for(lock, GROUP_COMMIT_WINDOW, [this] { return stopping_ || queue_.size() >= MAX_BATCH; });
+        std::vector<Mutation> mutations;
+        while (!queue_.empty() && mutations.size() < MAX_BATCH) {
+            mutations.push_back(std::move(queue_.front()));
+            queue_.pop_front();
+        }
+
+        lock.unlock();
+        commit(mutations);
+        lock.lock();
+    }
+}
+
+void Catalog::commit(std::vector<Mutation>& mutations) {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    WriteBatch batch(std::atomic_load(&current_));
+
+    // Изменения применяются по порядку поступления
+    std::vector<bool> results(mutations.size(), false);
+    std::vector<std::exception_ptr> errors(mutations.size());
+    for (size_t i = 0; i < mutations.size(); ++i) {
+        try {
+            results[i] = mutations[i].apply(batch);
+        }
+        catch (...) {
+            errors[i] = std::current_exception();
+        }
+    }
+
+    if (!batch.entries().empty()) {
+        try {
+            // Журнал, в котором остался обрыв прошлой пачки, снова
+            // принимает записи только после контрольной точки
+            if (wal().poisoned()) write_checkpoint();
+            wal().append(batch.entries());
+        }
+        catch (...) {
+            // Несохранённая пачка не публикуется целиком
+            Logger::log_error("Failed to write catalog journal, batch of " +
+                              std::to_string(mutations.size()) + " changes rejected");
+            for (auto& mutation : mutations) mutation.done.set_exception(std::current_exception());
+            return;
+        }
+        for (Dataset dataset : {Dataset::Cars, Dataset::Cities, Dataset::Documents}) {
+            if (batch.changed(dataset)) dirty_[static_cast<int>(dataset)] = true;
+        }
+        publish(batch.snapshot(version_.load(std::memory_order_relaxed) + 1));
+        try {
+            checkpoint_if_due();
+        }
+        catch (const std::exception& e) {
+            // Изменения уже в журнале; контрольная точка повторится со следующей пачкой
+            Logger::log_error("Catalog checkpoint failed: " + std::string(e.what()));
+        }
+    }
+
+    for (size_t i = 0; i < mutations.size(); ++i) {
+        if (errors[i]) mutations[i].done.set_exception(errors[i]);
+        else mutations[i].done.set_value(results[i]);
+    }
+}
+
+void Catalog::checkpoint_if_due() {
+    if (wal().size() >= CHECKPOINT_RECORDS) write_checkpoint();
+}
+
+void Catalog::checkpoint() {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    write_checkpoint();
+}
+
+void Catalog::write_checkpoint() {
+    auto current = std::atomic_load(&current_);
+    bool written = false;
+    for (Dataset dataset : {Dataset::Cars, Dataset::Cities, Dataset::Documents}) {
+        bool& dirty = dirty_[static_cast<int>(dataset)];
+        if (!dirty) continue;
+        bool saved = dataset == Dataset::Cars ? save_cars(*current->cars)
+                                              : save(dataset, *dataset_of(*current, dataset));
+        // Без сохранённого файла журнал нужен для восстановления
+        if (!saved) return;
+        if (dataset == Dataset::Cars) {
+            // После правок столбцы скопированы в память процесса; каталог
+            // переключается на только что записанный файл. Содержимое то же,
+            // поэтому cars_version не меняется
+            if (auto mapped = map_cars(data_dir_ + "/cars.snapshot")) {
+                auto snapshot = std::make_shared<CatalogSnapshot>(*current);
+                snapshot->cars = std::make_shared<const CarStore>(std::move(*mapped));
+                publish(std::move(snapshot));
+            }
+        }
+        if (dataset != Dataset::Cars) on_disk_[static_cast<int>(dataset)] = dataset_of(*current, dataset);
+        dirty = false;
+        written = true;
+    }
+    wal().reset();
+    if (written) Logger::log_info("Catalog checkpoint written");
+}
+
+// Публикация новой версии (вызывается под write_mutex_)
+void Catalog::publish(std::shared_ptr<CatalogSnapshot> snapshot) {
+    snapshot->version = version_.load(std::memory_order_relaxed) + 1;
+    std::atomic_store(&current_, std::shared_ptr<const CatalogSnapshot>(std::move(snapshot)));
+    version_.fetch_add(1, std::memory_order_release);
+}
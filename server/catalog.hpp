@@ -0,0 +1,226 @@
+#pragma once
+#include "../common/json.hpp"
+#include "car_store.hpp"
+#include "id_index.hpp"
+#include "wal.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+using json = nlohmann::json;
+
+// Наборы данных каталога (каждый хранится в своём файле data/*.json)
+enum class Dataset { Cars, Cities, Documents };
+
+// id записей, которые изменило (добавило, обновило или удалило) изменение
+// набора данных; пустой список — данные не менялись
+using ChangedIds = std::vector<int>;
+
+// Неизменяемая версия каталога. Наборы данных, которые не менялись
+// между версиями, разделяются через shared_ptr и не копируются.
+struct CatalogSnapshot {
+    std::shared_ptr<const CarStore> cars; // колоночное хранилище с индексами
+    std::shared_ptr<const json> cities;
+    std::shared_ptr<const json> documents;
+    std::shared_ptr<const IdIndex> city_ids;     // id -> позиция в cities
+    std::shared_ptr<const IdIndex> document_ids; // id -> позиция в documents["documents"]
+    uint64_t version = 0;
+    // Версия, в которой набор данных менялся последний раз
+    uint64_t cars_version = 0;
+    uint64_t cities_version = 0;
+    uint64_t documents_version = 0;
+
+    uint64_t version_of(Dataset dataset) const {
+        switch (dataset) {
+            case Dataset::Cars: return cars_version;
+            case Dataset::Cities: return cities_version;
+            case Dataset::Documents: break;
+        }
+        return documents_version;
+    }
+};
+
+// Резидентный каталог (RCU): читатели получают текущий снимок без блокировок,
+// писатели строят новую версию набора данных и атомарно её публикуют.
+// Старый снимок освобождается, когда его отпускает последний читатель.
+//
+// Изменения сохраняются не перезаписью data/*.json, а дописыванием в журнал
+// data/catalog.wal: по строке на изменённую запись — её новое состояние
+// целиком или удаление. Изменение публикуется только после fsync журнала.
+// Каждые CHECKPOINT_RECORDS записей (и при загрузке, если журнал не пуст)
+// изменённые наборы записываются через временный файл и rename — города и
+// документы в data/*.json, автомобили в бинарный снимок data/cars.snapshot
+// (cars.json только импортируется при старте, если он новее снимка), —
+// а журнал очищается. При загрузке журнал применяется к файлам;
+// запись журнала задаёт запись по id целиком, поэтому повторное применение
+// уже сохранённого в файл изменения ничего не меняет.
+//
+// Города и документы, исправленные в файлах вручную, подхватываются без
+// перезапуска: DataWatcher замечает изменение и вызывает reload().
+//
+// Изменения выполняет один поток записи (group commit): изменения,
+// пришедшие за GROUP_COMMIT_WINDOW (и пока идёт предыдущий fsync),
+// применяются по порядку к одной копии каждого набора, пишутся в журнал
+// одним fsync и публикуются одним снимком. modify() возвращается, когда
+// пачка с его изменением сохранена и опубликована.
+class Catalog {
+public:
+    static Catalog& instance();
+    ~Catalog();
+
+    // Загрузка всех наборов данных из каталога data_dir
+    void load(const std::string& data_dir = "data");
+
+    // Текущий снимок каталога
+    std::shared_ptr<const CatalogSnapshot> snapshot() const;
+
+    // Изменение городов или документов: f(json& records, IdIndex& ids)
+    // получает массив записей и его индекс по id в новой версии (и обновляет
+    // индекс вместе с массивом) и возвращает ChangedIds. Если данные
+    // изменились, записи пишутся в журнал и версия публикуется; ошибка
+    // журнала — std::runtime_error, и изменение не публикуется. Исключение
+    // из f передаётся вызывающему, поэтому f не должна бросать его после
+    // того, как изменила данные. Читателей изменения не блокируют.
+    template<class F>
+    bool modify(Dataset dataset, F&& f) {
+        return submit([&](WriteBatch& batch) {
+            ChangedIds changed = f(batch.records(dataset), batch.ids(dataset));
+            if (changed.empty()) return false;
+            batch.log(dataset, changed);
+            return true;
+        });
+    }
+
+    // Изменение автомобилей: f(CarStore&) получает хранилище новой версии
+    // (индексы обновляются его методами) и возвращает ChangedIds
+    template<class F>
+    bool modify_cars(F&& f) {
+        return submit([&](WriteBatch& batch) {
+            ChangedIds changed = f(batch.cars());
+            if (changed.empty()) return false;
+            batch.log(Dataset::Cars, changed);
+            return true;
+        });
+    }
+
+    // Запись изменённых наборов в data/*.json и очистка журнала
+    void checkpoint();
+
+    // Перечитывание городов или документов из data/*.json после правки
+    // файла вручную. Файл разбирается и проверяется (массив объектов без
+    // повторяющихся id) без блокировок, затем набор атомарно заменяется
+    // новой версией; изменения набора из журнала при этом отбрасываются —
+    // исправленный файл главнее. Файл с тем же содержимым, что каталог
+    // записал сам, пропускается. false — набор не заменён (файл испорчен
+    // или не изменился); changed_at — когда замечено изменение, от него
+    // считается задержка в логе.
+    bool reload(Dataset dataset,
+                std::chrono::steady_clock::time_point changed_at = std::chrono::steady_clock::now());
+
+    // reload() по шагам: разбор и проверка файла без блокировок, затем
+    // замена набора под блокировкой записи. Замена отменяется, если каталог
+    // переписал файл контрольной точкой после начала разбора.
+    struct PreparedReload {
+        Dataset dataset;
+        std::chrono::steady_clock::time_point changed_at;
+        std::string path;
+        std::shared_ptr<const json> on_disk; // содержимое файла по данным каталога до разбора
+        std::shared_ptr<IdIndex> ids;
+        std::shared_ptr<json> data;
+    };
+    std::optional<PreparedReload> prepare_reload(Dataset dataset,
+                                                 std::chrono::steady_clock::time_point changed_at = std::chrono::steady_clock::now());
+    bool apply_reload(const PreparedReload& prepared);
+
+    // Число записей журнала, после которого делается контрольная точка
+    static constexpr size_t CHECKPOINT_RECORDS = 1024;
+    // Сколько поток записи ждёт следующих изменений перед fsync и наибольший
+    // размер пачки (в сервере пачку ограничивает и число потоков, ждущих
+    // изменений, — CarDeliveryServer::BLOCKING_THREADS)
+    static constexpr std::chrono::microseconds GROUP_COMMIT_WINDOW{200};
+    static constexpr size_t MAX_BATCH = 256;
+
+private:
+    // Новая версия наборов данных, которую строит пачка изменений. Набор
+    // копируется из base при первом обращении; неизменённые наборы
+    // разделяются с прежним снимком.
+    class WriteBatch {
+    public:
+        explicit WriteBatch(std::shared_ptr<const CatalogSnapshot> base) : base_(std::move(base)) {}
+
+        CarStore& cars();
+        json& records(Dataset dataset);
+        IdIndex& ids(Dataset dataset);
+        // Записи журнала для изменённых id: состояние записи после изменения
+        void log(Dataset dataset, const ChangedIds& changed);
+
+        const std::vector<json>& entries() const { return entries_; }
+        bool changed(Dataset dataset) const { return changed_[static_cast<int>(dataset)]; }
+        // Снимок с изменёнными наборами (версии проставляет publish)
+        std::shared_ptr<CatalogSnapshot> snapshot(uint64_t version) const;
+
+    private:
+        std::shared_ptr<const CatalogSnapshot> base_;
+        std::shared_ptr<CarStore> cars_;
+        std::shared_ptr<json> data_[3];
+        std::shared_ptr<IdIndex> ids_[3];
+        bool changed_[3] = {false, false, false};
+        std::vector<json> entries_;
+    };
+
+    // Изменение в очереди потока записи
+    struct Mutation {
+        std::function<bool(WriteBatch&)> apply;
+        std::promise<bool> done;
+    };
+
+    Catalog();
+
+    static const std::shared_ptr<const json>& dataset_of(const CatalogSnapshot& snapshot, Dataset dataset);
+    static const std::shared_ptr<const IdIndex>& ids_of(const CatalogSnapshot& snapshot, Dataset dataset);
+    // Массив записей набора: города — весь файл, документы — поле "documents"
+    static json& records_of(json& data, Dataset dataset);
+    std::string path_for(Dataset dataset) const;
+    bool save(Dataset dataset, const json& data) const;
+    bool save_cars(const CarStore& cars) const;
+
+    // Постановка изменения в очередь и ожидание сохранения его пачки
+    bool submit(std::function<bool(WriteBatch&)> apply);
+    void run_writer();
+    // Применение, запись в журнал и публикация пачки
+    void commit(std::vector<Mutation>& mutations);
+
+    WriteAheadLog& wal();
+    void checkpoint_if_due();
+    // Контрольная точка под write_mutex_
+    void write_checkpoint();
+    void publish(std::shared_ptr<CatalogSnapshot> snapshot);
+
+    std::shared_ptr<const CatalogSnapshot> current_;
+    std::atomic<uint64_t> version_{0};
+    std::mutex write_mutex_;
+    std::string data_dir_ = "data";
+    std::unique_ptr<WriteAheadLog> wal_;
+    // Наборы, изменения которых есть только в журнале
+    bool dirty_[3] = {false, false, false};
+    // Содержимое городов и документов, которое сейчас лежит в data/*.json
+    // (загруженное или записанное каталогом): с ним reload сравнивает файл
+    std::shared_ptr<const json> on_disk_[3];
+
+    // Очередь потока записи
+    std::mutex queue_mutex_;
+    std::condition_variable queue_ready_;
+    std::deque<Mutation> queue_;
+    bool stopping_ = false;
+    std::thread writer_;
+};
@@ -0,0 +1,88 @@
+#include "data_watcher.hpp"
+#include "catalog.hpp"
+#include "../common/logger.hpp"
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace {
+
+// Как часто поток проверяет, не пора ли остановиться
+constexpr int POLL_TIMEOUT_MS = 200;
+
+// Набор данных, который хранится в файле name
+std::optional<Dataset> dataset_for(const char* name) {
+    if (std::strcmp(name, "cities.json") == 0) return Dataset::Cities;
+    if (std::strcmp(name, "documents.json") == 0) return Dataset::Documents;
+    return std::nullopt;
+}
+
+} // namespace
+
+DataWatcher::DataWatcher(const std::string& data_dir) : data_dir_(data_dir) {
+    fd_ = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd_ >= 0 && ::inotify_add_watch(fd_, data_dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    if (fd_ < 0) {
+        std::cerr << "Не удалось следить за " << data_dir << ": изменения файлов применятся после перезапуска\n";
+        Logger::log_error("Failed to watch " + data_dir + ": " + std::strerror(errno));
+        return;
+    }
+    thread_ = std::thread([this] { run(); });
+}
+
+DataWatcher::~DataWatcher() {
+    stopping_ = true;
+    if (thread_.joinable()) thread_.join();
+    if (fd_ >= 0) ::close(fd_);
+}
+
+void DataWatcher::run() {
+    using clock = std::chrono::steady_clock;
+    // Когда замечено первое ещё не обработанное изменение набора
+    std::optional<clock::time_point> changed[3];
+    clock::time_point last_event;
+    alignas(inotify_event) char buffer[4096];
+
+    while (!stopping_) {
+        bool pending = changed[static_cast<int>(Dataset::Cities)] || changed[static_cast<int>(Dataset::Documents)];
+        pollfd pfd{fd_, POLLIN, 0};
+        int timeout = pending ? static_cast<int>(DEBOUNCE.count()) : POLL_TIMEOUT_MS;
+        if (::poll(&pfd, 1, timeout) > 0) {
+            ssize_t length;
+            while ((length = ::read(fd_, buffer, sizeof(buffer))) > 0) {
+                for (ssize_t offset = 0; offset < length;) {
+                    const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+                    offset += sizeof(inotify_event) + event->len;
+                    if (event->len == 0) continue;
+                    if (auto dataset = dataset_for(event->name)) {
+                        auto& first = changed[static_cast<int>(*dataset)];
+                        last_event = clock::now();
+                        if (!first) first = last_event;
+                    }
+                }
+            }
+            continue;
+        }
+        if (!pending || clock::now() - last_event < DEBOUNCE) continue;
+
+        for (Dataset dataset : {Dataset::Cities, Dataset::Documents}) {
+            auto& first = changed[static_cast<int>(dataset)];
+            if (!first) continue;
+            try {
+                Catalog::instance().reload(dataset, *first);
+            }
+            catch (const std::exception& e) {
+                Logger::log_error(std::string("Hot reload failed: ") + e.what());
+            }
+            first.reset();
+        }
+    }
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+// Слежение за каталогом данных через inotify: после ручной правки
+// cities.json или documents.json фоновый поток перечитывает файл и
+// подменяет набор в каталоге (Catalog::reload) без перезапуска сервера.
+// Запросы при этом обслуживаются прежним снимком и не ждут разбора.
+//
+// Замечаются закрытие файла после записи и переименование в каталог
+// (редакторы и write_file_atomically пишут через временный файл).
+// События одного файла, пришедшие подряд, объединяются: файл перечитывается,
+// когда запись затихла на DEBOUNCE. cars.json не отслеживается — автомобили
+// импортируются из него только при старте.
+class DataWatcher {
+public:
+    static constexpr std::chrono::milliseconds DEBOUNCE{50};
+
+    // Без inotify (ошибка инициализации) сервер работает без перезагрузки
+    explicit DataWatcher(const std::string& data_dir);
+    ~DataWatcher();
+    DataWatcher(const DataWatcher&) = delete;
+    DataWatcher& operator=(const DataWatcher&) = delete;
+
+    bool watching() const { return fd_ >= 0; }
+
+private:
+    void run();
+
+    std::string data_dir_;
+    int fd_ = -1;
+    std::atomic<bool> stopping_{false};
+    std::thread thread_;
+};
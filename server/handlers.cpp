@@ -1,32 +1,276 @@
 #include "handlers.hpp"
+#include "catalog.hpp"
+#include "car_facets.hpp"
+#include "car_filter.hpp"
+#include "car_page.hpp"
+#include "car_suggest.hpp"
 #include "../common/logger.hpp"
 #include "../common/utils.hpp"
 #include "../common/json.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
 #include <iostream>
+#include <optional>
+#include <stdexcept>
 #include <string>
-#include <fstream>
 
 using json = nlohmann::json;
 
-// Вспомогательная функция: загрузка cars.json как JSON-объект
-json load_cars_db() {
-    std::string content = read_file("data/cars.json");
-    try {
-        return json::parse(content);
-    } catch (...) {
-        std::cerr << "Ошибка парсинга data/cars.json\n";
-        return json::array(); // пустой массив
+namespace {
+
+// Число подсказок по умолчанию и наибольшее
+constexpr size_t SUGGEST_LIMIT = 10;
+constexpr size_t MAX_SUGGEST_LIMIT = 50;
+
+// Курсор страницы — "<sort>;<ключ сортировки>;<id>" в hex. Клиент передаёт его
+// без изменений; выдача продолжается после автомобиля с этим id, поэтому
+// добавление и удаление других автомобилей не сдвигает страницы.
+std::string encode_cursor(const std::string& sort, std::optional<double> key, int id) {
+    char number[32] = "-";
+    if (key) std::snprintf(number, sizeof(number), "%.17g", *key);
+    std::string text = sort + ";" + number + ";" + std::to_string(id);
+
+    static const char HEX[] = "0123456789abcdef";
+    std::string cursor;
+    for (unsigned char c : text) {
+        cursor += HEX[c >> 4];
+        cursor += HEX[c & 0xF];
+    }
+    return cursor;
+}
+
+void decode_cursor(const std::string& cursor, std::string& sort, std::optional<double>& key, int& id) {
+    auto digit = [](char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        throw std::invalid_argument("Invalid cursor");
+    };
+    if (cursor.size() % 2 != 0) throw std::invalid_argument("Invalid cursor");
+    std::string text;
+    for (size_t i = 0; i < cursor.size(); i += 2) {
+        text += static_cast<char>(digit(cursor[i]) * 16 + digit(cursor[i + 1]));
+    }
+
+    size_t first = text.find(';');
+    size_t second = first == std::string::npos ? first : text.find(';', first + 1);
+    if (second == std::string::npos) throw std::invalid_argument("Invalid cursor");
+    sort = text.substr(0, first);
+
+    // Поле должно быть числом целиком: "12x" или число вне диапазона — тоже
+    // испорченный курсор, а не 12 или исключение out_of_range
+    auto parse = [](std::string_view field, auto& value) {
+        const char* end = field.data() + field.size();
+        auto [ptr, ec] = std::from_chars(field.data(), end, value);
+        if (ec != std::errc() || ptr != end) throw std::invalid_argument("Invalid cursor");
+    };
+    std::string_view number = std::string_view(text).substr(first + 1, second - first - 1);
+    if (number == "-") {
+        key = std::nullopt;
+    }
+    else {
+        double value = 0;
+        parse(number, value);
+        if (!std::isfinite(value)) throw std::invalid_argument("Invalid cursor");
+        key = value;
+    }
+    parse(std::string_view(text).substr(second + 1), id);
+}
+
+// Неотрицательное число из параметров страницы (в GET — строкой)
+size_t page_option(const json& options, const char* name, size_t fallback) {
+    if (!options.contains(name)) return fallback;
+    const json& value = options[name];
+    if (value.is_number_unsigned()) return value.get<size_t>();
+    if (value.is_string() && !value.get<std::string>().empty() &&
+        value.get<std::string>().find_first_not_of("0123456789") == std::string::npos) {
+        return std::stoul(value.get<std::string>());
     }
+    throw std::invalid_argument(std::string(name) + " must be a non-negative integer");
 }
 
-// GET /cars
-std::string handle_get_cars() {
-    json cars = load_cars_db();
-    return cars.dump();
+// Параметры строки запроса: a=1&b=Land%20Cruiser -> {"a": "1", "b": "Land Cruiser"}
+json query_params(std::string_view query_string) {
+    json params = json::object();
+    while (!query_string.empty()) {
+        size_t amp = query_string.find('&');
+        std::string_view param = query_string.substr(0, amp);
+        size_t eq = param.find('=');
+        if (eq != std::string_view::npos) {
+            params[url_decode(std::string(param.substr(0, eq)))] = url_decode(std::string(param.substr(eq + 1)));
+        }
+        if (amp == std::string_view::npos) break;
+        query_string.remove_prefix(amp + 1);
+    }
+    return params;
 }
 
-// POST /search — поиск по JSON-фильтрам с поддержкой >= и <=
-std::string handle_post_search(const std::string& body) {
+// Поля для вывода: "id,brand,model" (GET) или ["id", "brand", "model"] (POST);
+// без параметра выводятся все поля
+std::optional<CarStore::Projection> fields_option(const json& options) {
+    if (!options.contains("fields")) return std::nullopt;
+    const json& value = options["fields"];
+    std::vector<std::string> fields;
+    if (value.is_string()) {
+        std::string_view list = value.get_ref<const std::string&>();
+        while (!list.empty()) {
+            size_t comma = list.find(',');
+            if (comma != 0) fields.emplace_back(list.substr(0, comma));
+            if (comma == std::string_view::npos) break;
+            list.remove_prefix(comma + 1);
+        }
+    }
+    else if (value.is_array()) {
+        for (const auto& field : value) {
+            if (!field.is_string()) throw std::invalid_argument("fields must be a list of field names");
+            fields.push_back(field.get<std::string>());
+        }
+    }
+    else {
+        throw std::invalid_argument("fields must be a list of field names");
+    }
+    return CarStore::Projection(fields);
+}
+
+// JSON-массив автомобилей: с выбором полей — текстом прямо из столбцов
+void append_cars(std::string& out, const CarStore& cars, const std::vector<uint32_t>& rows,
+                 const std::optional<CarStore::Projection>& fields) {
+    out += '[';
+    for (size_t i = 0; i < rows.size(); ++i) {
+        if (i > 0) out += ',';
+        if (fields) cars.write_json(rows[i], *fields, out);
+        else out += cars.to_json(rows[i]).dump();
+    }
+    out += ']';
+}
+
+// Результат поиска: найденное число, строки страницы и курсор следующей
+struct SearchResult {
+    size_t found = 0;
+    std::vector<uint32_t> rows;
+    std::string next_cursor;
+};
+
+// Поиск автомобилей по фильтрам с постраничной выдачей. Параметры options:
+// limit, offset, sort ("price_usd" — по возрастанию, "-price_usd" — по
+// убыванию, только числовые поля) и cursor из next_cursor предыдущей
+// страницы. found — число всех подходящих автомобилей.
+SearchResult search_cars(const CarStore& cars, const json& filters, const json& options) {
+    CarFilter filter(cars, filters);
+
+    PageRequest page;
+    std::string sort = options.contains("sort") ? options["sort"].get<std::string>() : "";
+    if (!sort.empty()) {
+        page.descending = sort[0] == '-';
+        std::string field = page.descending ? sort.substr(1) : sort;
+        page.sort_column = CarStore::numeric_column(field);
+        if (page.sort_column < 0) throw std::invalid_argument("Unknown sort field: " + field);
+    }
+    page.offset = page_option(options, "offset", 0);
+    page.limit = page_option(options, "limit", page.limit);
+
+    if (options.contains("cursor")) {
+        std::string cursor_sort;
+        std::optional<double> key;
+        int id;
+        decode_cursor(options["cursor"].get<std::string>(), cursor_sort, key, id);
+        if (cursor_sort != sort) throw std::invalid_argument("Cursor does not match sort");
+        std::optional<uint32_t> row = cars.find_id(id);
+        if (!row) throw std::invalid_argument("Cursor is no longer valid");
+        page.after_row = row;
+        page.after_key = key;
+    }
+
+    SearchResult result;
+    // Нужно только число: позиции не извлекаются
+    if (page.limit == 0) {
+        result.found = filter.count();
+        return result;
+    }
+
+    std::vector<uint32_t> rows = filter.search();
+    Page selected = select_page(cars, rows, page);
+    result.found = rows.size();
+    result.rows = std::move(selected.rows);
+
+    json id;
+    if (selected.more && !result.rows.empty() &&
+        cars.value(result.rows.back(), "id", id) && id.is_number_integer()) {
+        std::optional<double> key;
+        if (page.sort_column >= 0) key = sort_key(cars, page.sort_column, result.rows.back());
+        result.next_cursor = encode_cursor(sort, key, id.get<int>());
+    }
+    return result;
+}
+
+// Ответ поиска {"found", "next_cursor", "results"} — ключи в порядке json::dump()
+std::string search_response(const CarStore& cars, const SearchResult& result,
+                            const std::optional<CarStore::Projection>& fields, bool omit_empty) {
+    std::string out = "{\"found\":" + std::to_string(result.found);
+    if (!result.next_cursor.empty()) {
+        out += ",\"next_cursor\":\"" + result.next_cursor + "\"";
+    }
+    if (!omit_empty || !result.rows.empty()) {
+        out += ",\"results\":";
+        append_cars(out, cars, result.rows, fields);
+    }
+    out += '}';
+    return out;
+}
+
+// Равенства строковых полей из строки запроса сравниваются без учёта
+// регистра: "toyota" заменяется на {"$in": ["Toyota", ...]} — все значения
+// словаря, совпадающие без учёта регистра. Без совпадений значение остаётся
+// как есть (и ничего не находит).
+void fold_string_filters(const CarStore& cars, json& filters) {
+    for (auto& [field, value] : filters.items()) {
+        int column = CarStore::string_column(field);
+        if (column < 0 || !value.is_string()) continue;
+        std::vector<uint32_t> ids = cars.index().text(column).exact(fold_case(value.get<std::string>()));
+        if (ids.empty()) continue;
+        json values = json::array();
+        for (uint32_t id : ids) values.push_back(cars.dictionary(column).value(id));
+        value = {{"$in", values}};
+    }
+}
+
+// Фасеты выбранных фильтрами автомобилей (без фильтров — всего каталога)
+std::string facets_response(const json& filters) {
+    auto snapshot = Catalog::instance().snapshot();
+    const CarStore& cars = *snapshot->cars;
+    if (filters.empty()) return car_facets(cars, nullptr).dump();
+    std::vector<uint32_t> rows = CarFilter(cars, filters).search();
+    return car_facets(cars, &rows).dump();
+}
+
+} // namespace
+
+// GET /cars?fields=id,brand,model
+std::string handle_get_cars(std::string_view query_string) {
+    auto snapshot = Catalog::instance().snapshot();
+    const CarStore& cars = *snapshot->cars;
+    try {
+        std::optional<CarStore::Projection> fields = fields_option(query_params(query_string));
+        if (!fields) return cars.to_json().dump();
+
+        std::vector<uint32_t> rows(cars.size());
+        for (uint32_t row = 0; row < rows.size(); ++row) rows[row] = row;
+        std::string out;
+        append_cars(out, cars, rows, fields);
+        return out;
+    }
+    catch (const std::exception& e) {
+        Logger::log_warning("GET /cars error: " + std::string(e.what()));
+        json response;
+        response["error"] = e.what();
+        return response.dump();
+    }
+}
+
+// POST /search — поиск по JSON-фильтрам с операторами сравнения ($gt, $gte, $lt, $lte, $ne, $in, $between);
+// в теле также limit, offset, sort и cursor для постраничной выдачи и fields для выбора полей
+std::string handle_post_search(std::string_view body) {
     try {
         std::cout << "POST /search body: " << body << std::endl;
            Logger::log_info("Processing POST /search with body length: " + std::to_string(body.length()));
@@ -38,72 +282,24 @@ std::string handle_post_search(const std::string& body) {
 
         json request = json::parse(body);
         json filters = request.value("filters", json::object());
-        json cars = load_cars_db();
-        json results = json::array();
 
         std::cout << "Фильтры: " << filters.dump() << std::endl;
 
-        for (const auto& car : cars) {
-            bool match = true;
-
-            for (auto& [key, filter_value] : filters.items()) {
-                if (!car.contains(key)) {
-                    match = false;
-                    break;
-                }
+        std::optional<CarStore::Projection> fields = fields_option(request);
+        auto snapshot = Catalog::instance().snapshot();
+        SearchResult result = search_cars(*snapshot->cars, filters, request);
 
-                auto car_value = car[key];
-
-                // Если фильтр - объект с операторами (>=, <=)
-                if (filter_value.is_object()) {
-                    for (auto& [op, value] : filter_value.items()) {
-                        if (op == "$gte") {
-                            // Больше или равно >=
-                            if (!(car_value >= value)) {
-                                match = false;
-                                break;
-                            }
-                        }
-                        else if (op == "$lte") {
-                            // Меньше или равно <=
-                            if (!(car_value <= value)) {
-                                match = false;
-                                break;
-                            }
-                        }
-                        else {
-                            // Неизвестный оператор - считаем как равно
-                            if (car_value != value) {
-                                match = false;
-                                break;
-                            }
-                        }
-                    }
-                }
-                // Простое сравнение (по умолчанию =)
-                else {
-                    if (car_value != filter_value) {
-                        match = false;
-                        break;
-                    }
-                }
-
-                if (!match) break;
-            }
-
-            if (match) {
-                results.push_back(car);
-            }
-        }
+        std::cout << "Найдено " << result.found << " результаты" << std::endl;
+        Logger::log_info("POST /search found " + std::to_string(result.found) + " results");
+        return search_response(*snapshot->cars, result, fields, false);
 
+    }
+    catch (const std::invalid_argument& e) {
+        // Ошибка в фильтрах (неизвестный оператор, неверный операнд) или параметрах страницы
+        Logger::log_warning("POST /search rejected filters: " + std::string(e.what()));
         json response;
-        response["found"] = results.size();
-        response["results"] = results;
-
-        std::cout << "Найдено " << results.size() << " результаты" << std::endl;
-        Logger::log_info("POST /search found " + std::to_string(results.size()) + " results");
+        response["error"] = e.what();
         return response.dump();
-
     }
     catch (const std::exception& e) {
         std::cerr << "Search error: " << e.what() << std::endl;
@@ -112,84 +308,125 @@ std::string handle_post_search(const std::string& body) {
     }
 }
 
-// GET /search?brand=...&model=...
-std::string handle_get_search(const std::string& query_string) {
-    // Простой парсинг query_string: brand=Toyota&model=Camry
-    json filters;
-    std::istringstream iss(query_string);
-    std::string param;
-    while (std::getline(iss, param, '&')) {
-        size_t eq = param.find('=');
-        if (eq != std::string::npos) {
-            std::string key = param.substr(0, eq);
-            std::string value = param.substr(eq + 1);
-            filters[key] = value;
-        }
-    }
-
-    json cars = load_cars_db();
-    json results = json::array();
-    for (const auto& car : cars) {
-        bool match = true;
-        for (auto& [key, value] : filters.items()) {
-            if (!car.contains(key) || car[key] != value) {
-                match = false;
-                break;
+// GET /search?brand=...&model=...&sort=-price_usd&limit=20&cursor=...&fields=id,brand
+std::string handle_get_search(std::string_view query_string) {
+    try {
+        // Параметры страницы и вывода не являются фильтрами
+        json filters = query_params(query_string);
+        json options = json::object();
+        for (const char* name : {"limit", "offset", "sort", "cursor", "fields"}) {
+            if (filters.contains(name)) {
+                options[name] = filters[name];
+                filters.erase(name);
             }
         }
-        if (match) {
-            results.push_back(car);
-        }
-    }
 
-    json response;
-    response["found"] = results.size();
-    if (!results.empty()) {
-        response["results"] = results;
+        std::optional<CarStore::Projection> fields = fields_option(options);
+        auto snapshot = Catalog::instance().snapshot();
+        fold_string_filters(*snapshot->cars, filters);
+        SearchResult result = search_cars(*snapshot->cars, filters, options);
+        return search_response(*snapshot->cars, result, fields, true);
+    }
+    catch (const std::exception& e) {
+        Logger::log_warning("GET /search error: " + std::string(e.what()));
+        json response;
+        response["error"] = e.what();
+        return response.dump();
     }
-    return response.dump();
 }
 
-// Вспомогательная функция: загрузка cities.json как JSON-объект
-json load_cities_db() {
-    std::string content = read_file("data/cities.json");
+// GET /cars/facets?brand=Toyota — число автомобилей по значениям полей и гистограммы
+std::string handle_get_car_facets(std::string_view query_string) {
     try {
-        return json::parse(content);
-    } catch (...) {
-        std::cerr << "Ошибка парсинга data/cities.json\n";
-        return json::array(); // пустой массив
+        return facets_response(query_params(query_string));
+    }
+    catch (const std::exception& e) {
+        Logger::log_warning("GET /cars/facets error: " + std::string(e.what()));
+        json response;
+        response["error"] = e.what();
+        return response.dump();
     }
 }
 
-// GET /cities
-std::string handle_get_cities() {
-   json cities = load_cities_db();
-    
-    return cities.dump();
+// POST /cars/facets — фасеты по тем же фильтрам, что у POST /search
+std::string handle_post_car_facets(std::string_view body) {
+    try {
+        json request = json::parse(body);
+        return facets_response(request.value("filters", json::object()));
+    }
+    catch (const std::exception& e) {
+        Logger::log_warning("POST /cars/facets error: " + std::string(e.what()));
+        json response;
+        response["error"] = e.what();
+        return response.dump();
+    }
 }
 
-// Вспомогательная функция: загрузка documents.json как JSON-объект
-json load_documents_db() {
-    std::string content = read_file("data/documents.json");
+// GET /cars/suggest?q=cru&field=model&limit=10&brand=Toyota — подсказки для
+// автодополнения марки и модели; остальные параметры — фильтры, внутри
+// которых считается число автомобилей
+std::string handle_get_car_suggest(std::string_view query_string) {
     try {
-        json data = json::parse(content);
-        return data;
+        json filters = query_params(query_string);
+        json options = json::object();
+        for (const char* name : {"q", "field", "limit"}) {
+            if (filters.contains(name)) {
+                options[name] = filters[name];
+                filters.erase(name);
+            }
+        }
+        if (!options.contains("q") || options["q"].get<std::string>().empty()) {
+            throw std::invalid_argument("q is required");
+        }
+        std::string query = options["q"].get<std::string>();
+
+        std::vector<size_t> columns;
+        std::string field = options.value("field", "");
+        if (field.empty()) {
+            columns = {static_cast<size_t>(CarStore::string_column("brand")),
+                       static_cast<size_t>(CarStore::string_column("model"))};
+        }
+        else {
+            int column = CarStore::string_column(field);
+            if (column < 0) throw std::invalid_argument("Unknown suggest field: " + field);
+            columns = {static_cast<size_t>(column)};
+        }
+        size_t limit = std::min(page_option(options, "limit", SUGGEST_LIMIT), MAX_SUGGEST_LIMIT);
+
+        auto snapshot = Catalog::instance().snapshot();
+        const CarStore& cars = *snapshot->cars;
+        std::optional<RoaringBitmap> selection;
+        if (!filters.empty()) {
+            fold_string_filters(cars, filters);
+            selection = RoaringBitmap::from_sorted(CarFilter(cars, filters).search());
+        }
+
+        json response;
+        response["query"] = query;
+        response["suggestions"] = car_suggestions(cars, query, columns, selection ? &*selection : nullptr, limit);
+        return response.dump();
     }
-    catch (...) {
-        std::cerr << "Ошибка парсинга data/documents.json\n";
-        return json::object(); // возвращаем пустой объект
+    catch (const std::exception& e) {
+        Logger::log_warning("GET /cars/suggest error: " + std::string(e.what()));
+        json response;
+        response["error"] = e.what();
+        return response.dump();
     }
 }
 
+// GET /cities
+std::string handle_get_cities() {
+    auto snapshot = Catalog::instance().snapshot();
+    return snapshot->cities->dump();
+}
+
 // GET /documents
 std::string handle_get_documents() {
     try {
-        // Загружаем документы из файла
-        json documents = load_documents_db();
-
         // Форматируем ответ для клиента
+        auto snapshot = Catalog::instance().snapshot();
         json response;
-        response["documents"] = documents["documents"];
+        response["documents"] = (*snapshot->documents)["documents"];
         return response.dump();
     }
     catch (const std::exception& e) {
@@ -215,7 +452,7 @@ std::string handle_get_delivery() {
 }
 
 // POST /admin/login
-std::string handle_post_admin_login(const std::string& body) {
+std::string handle_post_admin_login(std::string_view body) {
     try {
         json creds = json::parse(body);
         std::string username = creds.value("username", "");
@@ -297,7 +534,7 @@ double calculate_utilization_fee(double engine_volume, int horsepower, int car_a
 }
 
 // POST /calculate-delivery - расчёт стоимости доставки
-std::string handle_post_calculate_delivery(const std::string& body) {
+std::string handle_post_calculate_delivery(std::string_view body) {
     try {
         json request = json::parse(body);
         int car_id = request.value("car_id", 0);
@@ -307,36 +544,25 @@ std::string handle_post_calculate_delivery(const std::string& body) {
             return R"({"error": "car_id and city_id are required"})";
         }
 
-        // Загружаем данные
-        json cars = load_cars_db();
-        json cities_json = json::parse(read_file("data/cities.json"));
-
-        // Находим автомобиль
+        // Находим автомобиль и город в каталоге
         json car;
+        json city;
         bool car_found = false;
-        for (const auto& c : cars) {
-            if (c.value("id", 0) == car_id) {
-                car = c;
-                car_found = true;
-                break;
-            }
+        bool city_found = false;
+        auto snapshot = Catalog::instance().snapshot();
+        if (auto row = snapshot->cars->find_id(car_id)) {
+            car = snapshot->cars->to_json(*row);
+            car_found = true;
+        }
+        if (auto slot = snapshot->city_ids->find(city_id)) {
+            city = (*snapshot->cities)[*slot];
+            city_found = true;
         }
 
         if (!car_found) {
             return R"({"error": "Car not found"})";
         }
 
-        // Находим город
-        json city;
-        bool city_found = false;
-        for (const auto& ct : cities_json) {
-            if (ct.value("id", 0) == city_id) {
-                city = ct;
-                city_found = true;
-                break;
-            }
-        }
-
         if (!city_found) {
             return R"({"error": "City not found"})";
         }
@@ -512,23 +738,14 @@ std::string handle_post_calculate_delivery(const std::string& body) {
         return R"({"error": "Calculation failed: )" + std::string(e.what()) + "\"}";
     }
 }
-// Вспомогательная функция: сохранение данных в JSON-файл
-void save_to_file(const std::string& filename, const json& data) {
-    std::ofstream file(filename);
-    if (file.is_open()) {
-        file << data.dump(4); // Форматируем с отступами для удобства чтения
-        file.close();
-    }
-}
 
 // GET /admin/cars - получить список автомобилей (для админов)
 std::string handle_get_admin_cars() {
-    json cars = load_cars_db();
-    return cars.dump();
+    return handle_get_cars({});
 }
 
 // POST /admin/cars - добавить новый автомобиль
-std::string handle_post_admin_cars(const std::string& body) {
+std::string handle_post_admin_cars(std::string_view body) {
     try {
         json new_car = json::parse(body);
 
@@ -538,22 +755,14 @@ std::string handle_post_admin_cars(const std::string& body) {
             return R"({"error": "Missing required fields: brand, model, year, price_usd"})";
         }
 
-        // Загружаем существующую базу
-        json cars = load_cars_db();
-
-        // Генерируем новый ID (максимальный ID + 1)
-        int max_id = 0;
-        for (const auto& car : cars) {
-            int id = car.value("id", 0);
-            if (id > max_id) max_id = id;
-        }
-        new_car["id"] = max_id + 1;
-
-        // Добавляем новый автомобиль
-        cars.push_back(new_car);
+        Catalog::instance().modify_cars([&](CarStore& cars) -> ChangedIds {
+            int car_id = cars.allocate_id();
+            new_car["id"] = car_id;
 
-        // Сохраняем в файл
-        save_to_file("data/cars.json", cars);
+            // Добавляем новый автомобиль
+            cars.append(new_car);
+            return {car_id};
+        });
 
         json response;
         response["status"] = "success";
@@ -567,38 +776,35 @@ std::string handle_post_admin_cars(const std::string& body) {
 }
 
 // PUT /admin/cars/{id} - обновить информацию об автомобиле
-std::string handle_put_admin_cars(int car_id, const std::string& body) {
+std::string handle_put_admin_cars(int car_id, std::string_view body) {
     try {
         json updated_car = json::parse(body);
 
-        // Загружаем существующую базу
-        json cars = load_cars_db();
-
         // Находим и обновляем автомобиль
-        bool found = false;
-        for (auto& car : cars) {
-            if (car.value("id", 0) == car_id) {
-                // Обновляем только те поля, которые присутствуют в запросе
-                for (auto& [key, value] : updated_car.items()) {
-                    car[key] = value;
-                }
-                car["id"] = car_id; // Убедимся, что ID не изменился
-                found = true;
-                break;
+        json result;
+        bool found = Catalog::instance().modify_cars([&](CarStore& cars) -> ChangedIds {
+            auto row = cars.find_id(car_id);
+            if (!row) return {};
+
+            // Обновляем только те поля, которые присутствуют в запросе
+            json car = cars.to_json(*row);
+            for (auto& [key, value] : updated_car.items()) {
+                car[key] = value;
             }
-        }
+            car["id"] = car_id; // Убедимся, что ID не изменился
+            cars.update(*row, car);
+            result = car;
+            return {car_id};
+        });
 
         if (!found) {
             return R"({"error": "Car with id )" + std::to_string(car_id) + R"( not found"})";
         }
 
-        // Сохраняем в файл
-        save_to_file("data/cars.json", cars);
-
         json response;
         response["status"] = "success";
         response["message"] = "Car updated successfully";
-        response["car"] = cars[car_id - 1]; // Возвращаем обновленный автомобиль
+        response["car"] = result; // Возвращаем обновленный автомобиль
         return response.dump();
     }
     catch (const std::exception& e) {
@@ -609,26 +815,18 @@ std::string handle_put_admin_cars(int car_id, const std::string& body) {
 // DELETE /admin/cars/{id} - удалить автомобиль
 std::string handle_delete_admin_cars(int car_id) {
     try {
-        // Загружаем существующую базу
-        json cars = load_cars_db();
-
         // Находим и удаляем автомобиль
-        bool found = false;
-        for (auto it = cars.begin(); it != cars.end(); ++it) {
-            if (it->value("id", 0) == car_id) {
-                cars.erase(it);
-                found = true;
-                break;
-            }
-        }
+        bool found = Catalog::instance().modify_cars([&](CarStore& cars) -> ChangedIds {
+            auto row = cars.find_id(car_id);
+            if (!row) return {};
+            cars.remove(*row);
+            return {car_id};
+        });
 
         if (!found) {
             return R"({"error": "Car with id )" + std::to_string(car_id) + R"( not found"})";
         }
 
-        // Сохраняем в файл
-        save_to_file("data/cars.json", cars);
-
         json response;
         response["status"] = "success";
         response["message"] = "Car deleted successfully";
@@ -639,14 +837,103 @@ std::string handle_delete_admin_cars(int car_id) {
     }
 }
 
+// POST /admin/cars/bulk - пакетное добавление и обновление автомобилей.
+// Тело — NDJSON: по объекту автомобиля на строку. Строка с id существующего
+// автомобиля обновляет его поля (как PUT), остальные добавляют автомобиль
+// (обязательны brand, model, year, price_usd; без id он выдаётся). Все
+// верные строки применяются одним изменением каталога и одной записью
+// журнала, индексы перестраиваются один раз в конце; неверные строки
+// пропускаются. В ответе — статус каждой строки.
+std::string handle_post_admin_cars_bulk(std::string_view body) {
+    try {
+        // Строки разбираются по одной прямо из тела запроса
+        struct Row {
+            size_t result; // позиция в results
+            json car;
+        };
+        std::vector<Row> rows;
+        std::vector<json> results;
+        size_t line = 0;
+        while (!body.empty()) {
+            size_t end = body.find('\n');
+            std::string_view text = body.substr(0, end);
+            body.remove_prefix(end == std::string_view::npos ? body.size() : end + 1);
+            ++line;
+            if (!text.empty() && text.back() == '\r') text.remove_suffix(1);
+            if (text.find_first_not_of(" \t") == std::string_view::npos) continue;
+
+            json car = json::parse(text, nullptr, false);
+            if (car.is_discarded() || !car.is_object()) {
+                results.push_back({{"line", line}, {"status", "error"}, {"error", "Invalid JSON object"}});
+                continue;
+            }
+            // Иначе get<int>() молча обрезал бы, например, 4294967297 до 1
+            if (car.contains("id") && !CarStore::valid_id(car["id"])) {
+                results.push_back({{"line", line}, {"status", "error"}, {"error", "id must be a 32-bit integer"}});
+                continue;
+            }
+            rows.push_back({results.size(), std::move(car)});
+            results.push_back({{"line", line}});
+        }
+
+        size_t created = 0, updated = 0;
+        Catalog::instance().modify_cars([&](CarStore& cars) -> ChangedIds {
+            ChangedIds changed;
+            CarStore::BulkUpdate bulk(cars);
+            for (auto& row : rows) {
+                json& result = results[row.result];
+                json& car = row.car;
+
+                std::optional<uint32_t> existing;
+                if (car.contains("id")) existing = cars.find_id(car["id"].get<int>());
+                if (existing) {
+                    json merged = cars.to_json(*existing);
+                    for (auto& [key, value] : car.items()) merged[key] = value;
+                    cars.update(*existing, merged);
+                    result["status"] = "updated";
+                    ++updated;
+                }
+                else if (!car.contains("brand") || !car.contains("model") ||
+                         !car.contains("year") || !car.contains("price_usd")) {
+                    result["status"] = "error";
+                    result["error"] = "Missing required fields: brand, model, year, price_usd";
+                    continue;
+                }
+                else {
+                    if (!car.contains("id")) car["id"] = cars.allocate_id();
+                    cars.append(car);
+                    result["status"] = "created";
+                    ++created;
+                }
+                result["id"] = car["id"];
+                changed.push_back(car["id"].get<int>());
+            }
+            return changed;
+        });
+
+        Logger::log_info("POST /admin/cars/bulk: " + std::to_string(created) + " created, " +
+                         std::to_string(updated) + " updated, " +
+                         std::to_string(results.size() - created - updated) + " failed");
+        json response;
+        response["status"] = "success";
+        response["created"] = created;
+        response["updated"] = updated;
+        response["failed"] = results.size() - created - updated;
+        response["results"] = std::move(results);
+        return response.dump();
+    }
+    catch (const std::exception& e) {
+        return R"({"error": "Failed to import cars: )" + std::string(e.what()) + "\"}";
+    }
+}
+
 // GET /admin/cities - получить список городов (для админов)
 std::string handle_get_admin_cities() {
-    json cities = load_cities_db();
-    return cities.dump();
+    return handle_get_cities();
 }
 
 // POST /admin/cities - добавить новый город
-std::string handle_post_admin_cities(const std::string& body) {
+std::string handle_post_admin_cities(std::string_view body) {
     try {
         json new_city = json::parse(body);
 
@@ -656,22 +943,15 @@ std::string handle_post_admin_cities(const std::string& body) {
             return R"({"error": "Missing required fields: name, delivery_days, delivery_cost"})";
         }
 
-        // Загружаем существующую базу
-        json cities = load_cities_db();
-
-        // Генерируем новый ID (максимальный ID + 1)
-        int max_id = 0;
-        for (const auto& city : cities) {
-            int id = city.value("id", 0);
-            if (id > max_id) max_id = id;
-        }
-        new_city["id"] = max_id + 1;
+        Catalog::instance().modify(Dataset::Cities, [&](json& cities, IdIndex& ids) -> ChangedIds {
+            int city_id = ids.allocate();
+            new_city["id"] = city_id;
 
-        // Добавляем новый город
-        cities.push_back(new_city);
-
-        // Сохраняем в файл
-        save_to_file("data/cities.json", cities);
+            // Добавляем новый город
+            ids.insert(city_id, static_cast<uint32_t>(cities.size()));
+            cities.push_back(new_city);
+            return {city_id};
+        });
 
         json response;
         response["status"] = "success";
@@ -685,43 +965,34 @@ std::string handle_post_admin_cities(const std::string& body) {
 }
 
 // PUT /admin/cities/{id} - обновить информацию о городе
-std::string handle_put_admin_cities(int city_id, const std::string& body) {
+std::string handle_put_admin_cities(int city_id, std::string_view body) {
     try {
         json updated_city = json::parse(body);
 
-        // Загружаем существующую базу
-        json cities = load_cities_db();
-
         // Находим и обновляем город
-        bool found = false;
-        for (auto& city : cities) {
-            if (city.value("id", 0) == city_id) {
-                // Обновляем только те поля, которые присутствуют в запросе
-                for (auto& [key, value] : updated_city.items()) {
-                    city[key] = value;
-                }
-                city["id"] = city_id; // Убедимся, что ID не изменился
-                found = true;
-                break;
+        json result;
+        bool found = Catalog::instance().modify(Dataset::Cities, [&](json& cities, IdIndex& ids) -> ChangedIds {
+            auto slot = ids.find(city_id);
+            if (!slot) return {};
+
+            // Обновляем только те поля, которые присутствуют в запросе
+            json& city = cities[*slot];
+            for (auto& [key, value] : updated_city.items()) {
+                city[key] = value;
             }
-        }
+            city["id"] = city_id; // Убедимся, что ID не изменился
+            result = city;
+            return {city_id};
+        });
 
         if (!found) {
             return R"({"error": "City with id )" + std::to_string(city_id) + R"( not found"})";
         }
 
-        // Сохраняем в файл
-        save_to_file("data/cities.json", cities);
-
         json response;
         response["status"] = "success";
         response["message"] = "City updated successfully";
-        for (const auto& city : cities) {
-            if (city.value("id", 0) == city_id) {
-                response["city"] = city;
-                break;
-            }
-        }
+        response["city"] = result;
         return response.dump();
     }
     catch (const std::exception& e) {
@@ -732,26 +1003,20 @@ std::string handle_put_admin_cities(int city_id, const std::string& body) {
 // DELETE /admin/cities/{id} - удалить город
 std::string handle_delete_admin_cities(int city_id) {
     try {
-        // Загружаем существующую базу
-        json cities = load_cities_db();
-
         // Находим и удаляем город
-        bool found = false;
-        for (auto it = cities.begin(); it != cities.end(); ++it) {
-            if (it->value("id", 0) == city_id) {
-                cities.erase(it);
-                found = true;
-                break;
-            }
-        }
+        bool found = Catalog::instance().modify(Dataset::Cities, [&](json& cities, IdIndex& ids) -> ChangedIds {
+            auto slot = ids.find(city_id);
+            if (!slot) return {};
+            cities.erase(cities.begin() + *slot);
+            ids.erase(city_id);
+            ids.shift_after(*slot);
+            return {city_id};
+        });
 
         if (!found) {
             return R"({"error": "City with id )" + std::to_string(city_id) + R"( not found"})";
         }
 
-        // Сохраняем в файл
-        save_to_file("data/cities.json", cities);
-
         json response;
         response["status"] = "success";
         response["message"] = "City deleted successfully";
@@ -765,14 +1030,8 @@ std::string handle_delete_admin_cities(int city_id) {
 // GET /admin/documents - получить список документов (для админов)
 std::string handle_get_admin_documents() {
     try {
-        json documents_data = load_documents_db();
-
-        // Возвращаем объект с ключом "documents" для единообразия
-        if (!documents_data.contains("documents")) {
-            documents_data["documents"] = json::array();
-        }
-
-        return documents_data.dump();
+        auto snapshot = Catalog::instance().snapshot();
+        return snapshot->documents->dump();
     }
     catch (const std::exception& e) {
         std::cerr << "Error loading documents: " << e.what() << std::endl;
@@ -781,7 +1040,7 @@ std::string handle_get_admin_documents() {
 }
 
 // POST /admin/documents - добавить новый документ
-std::string handle_post_admin_documents(const std::string& body) {
+std::string handle_post_admin_documents(std::string_view body) {
     try {
         json new_document = json::parse(body);
 
@@ -790,29 +1049,15 @@ std::string handle_post_admin_documents(const std::string& body) {
             return R"({"error": "Missing required fields: category, name"})";
         }
 
-        // Загружаем существующую базу
-        json documents_data = load_documents_db();
+        Catalog::instance().modify(Dataset::Documents, [&](json& documents, IdIndex& ids) -> ChangedIds {
+            int doc_id = ids.allocate();
+            new_document["id"] = doc_id;
 
-        // Проверяем структуру и инициализируем массив документов если нужно
-        if (!documents_data.contains("documents")) {
-            documents_data["documents"] = json::array();
-        }
-
-        json& documents = documents_data["documents"];
-
-        // Генерируем новый ID (максимальный ID + 1)
-        int max_id = 0;
-        for (const auto& doc : documents) {
-            int id = doc.value("id", 0);
-            if (id > max_id) max_id = id;
-        }
-        new_document["id"] = max_id + 1;
-
-        // Добавляем новый документ
-        documents.push_back(new_document);
-
-        // Сохраняем в файл
-        save_to_file("data/documents.json", documents_data);
+            // Добавляем новый документ
+            ids.insert(doc_id, static_cast<uint32_t>(documents.size()));
+            documents.push_back(new_document);
+            return {doc_id};
+        });
 
         json response;
         response["status"] = "success";
@@ -827,7 +1072,7 @@ std::string handle_post_admin_documents(const std::string& body) {
 }
 
 // DELETE /admin/documents - удалить документ
-std::string handle_delete_admin_documents(const std::string& body) {
+std::string handle_delete_admin_documents(std::string_view body) {
     try {
         json request = json::parse(body);
         int doc_id = request.value("id", 0);
@@ -836,33 +1081,20 @@ std::string handle_delete_admin_documents(const std::string& body) {
             return R"({"error": "Missing required field: id"})";
         }
 
-        // Загружаем существующую базу
-        json documents_data = load_documents_db();
-
-        // Проверяем структуру
-        if (!documents_data.contains("documents")) {
-            return R"({"error": "No documents found in database"})";
-        }
-
-        json& documents = documents_data["documents"];
-
         // Находим и удаляем документ
-        bool found = false;
-        for (auto it = documents.begin(); it != documents.end(); ++it) {
-            if (it->value("id", 0) == doc_id) {
-                documents.erase(it);
-                found = true;
-                break;
-            }
-        }
+        bool found = Catalog::instance().modify(Dataset::Documents, [&](json& documents, IdIndex& ids) -> ChangedIds {
+            auto slot = ids.find(doc_id);
+            if (!slot) return {};
+            documents.erase(documents.begin() + *slot);
+            ids.erase(doc_id);
+            ids.shift_after(*slot);
+            return {doc_id};
+        });
 
         if (!found) {
             return R"({"error": "Document with id )" + std::to_string(doc_id) + R"( not found"})";
         }
 
-        // Сохраняем в файл
-        save_to_file("data/documents.json", documents_data);
-
         json response;
         response["status"] = "success";
         response["message"] = "Document deleted successfully";
@@ -872,4 +1104,4 @@ std::string handle_delete_admin_documents(const std::string& body) {
         std::cerr << "Error deleting document: " << e.what() << std::endl;
         return R"({"error": "Failed to delete document: )" + std::string(e.what()) + "\"}";
     }
-}
\ No newline at end of file
+}
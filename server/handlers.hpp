@@ -1,27 +1,32 @@
 #pragma once
 #include <string>
+#include <string_view>
 
 // Эндпоинты клиентской части
-std::string handle_get_cars();
-std::string handle_post_search(const std::string& body);
-std::string handle_get_search(const std::string& query_string);
+std::string handle_get_cars(std::string_view query_string = {});
+std::string handle_post_search(std::string_view body);
+std::string handle_get_search(std::string_view query_string);
+std::string handle_get_car_facets(std::string_view query_string = {});
+std::string handle_post_car_facets(std::string_view body);
+std::string handle_get_car_suggest(std::string_view query_string);
 std::string handle_get_cities();
 std::string handle_get_documents();
 std::string handle_get_delivery();
-std::string handle_post_calculate_delivery(const std::string& body);
+std::string handle_post_calculate_delivery(std::string_view body);
 
 // Эндпоинты админки
-std::string handle_post_admin_login(const std::string& body);
+std::string handle_post_admin_login(std::string_view body);
 std::string handle_get_admin_cars();
-std::string handle_post_admin_cars(const std::string& body);
-std::string handle_put_admin_cars(int car_id, const std::string& body);
+std::string handle_post_admin_cars(std::string_view body);
+std::string handle_post_admin_cars_bulk(std::string_view body);
+std::string handle_put_admin_cars(int car_id, std::string_view body);
 std::string handle_delete_admin_cars(int car_id);
 std::string handle_get_admin_cities();
-std::string handle_post_admin_cities(const std::string& body);
-std::string handle_put_admin_cities(int city_id, const std::string& body);
+std::string handle_post_admin_cities(std::string_view body);
+std::string handle_put_admin_cities(int city_id, std::string_view body);
 std::string handle_delete_admin_cities(int city_id);
 std::string handle_get_admin_documents();
-std::string handle_post_admin_documents(const std::string& body);
-std::string handle_delete_admin_documents(const std::string& body);
+std::string handle_post_admin_documents(std::string_view body);
+std::string handle_delete_admin_documents(std::string_view body);
 // Функция расчета утильсбора
 double calculate_utilization_fee(double engine_volume, int horsepower, int car_age);
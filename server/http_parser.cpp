@@ -0,0 +1,292 @@
+#include "http_parser.hpp"
+#include <cctype>
+#include <cstring>
+
+namespace {
+
+bool iequals(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (std::tolower(static_cast<unsigned char>(a[i])) != std::tolower(static_cast<unsigned char>(b[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string_view trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) s.remove_suffix(1);
+    return s;
+}
+
+// Есть ли в списке через запятую (Connection, Transfer-Encoding) нужный токен
+bool has_token(std::string_view list, std::string_view token) {
+    while (!list.empty()) {
+        size_t comma = list.find(',');
+        if (iequals(trim(list.substr(0, comma)), token)) return true;
+        if (comma == std::string_view::npos) break;
+        list.remove_prefix(comma + 1);
+    }
+    return false;
+}
+
+// Строгий разбор десятичного числа без знака
+bool parse_size(std::string_view s, size_t& out) {
+    if (s.empty() || s.size() > 18) return false;
+    size_t value = 0;
+    for (char c : s) {
+        if (c < '0' || c > '9') return false;
+        value = value * 10 + static_cast<size_t>(c - '0');
+    }
+    out = value;
+    return true;
+}
+
+bool parse_hex_size(std::string_view s, size_t& out) {
+    if (s.empty() || s.size() > 15) return false;
+    size_t value = 0;
+    for (char c : s) {
+        int digit;
+        if (c >= '0' && c <= '9') digit = c - '0';
+        else if (c >= 'a' && c <= 'f') digit = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') digit = c - 'A' + 10;
+        else return false;
+        value = value * 16 + static_cast<size_t>(digit);
+    }
+    out = value;
+    return true;
+}
+
+} // namespace
+
+std::string_view HttpRequest::header(std::string_view name) const {
+    for (const auto& h : headers) {
+        if (iequals(h.name, name)) return h.value;
+    }
+    return {};
+}
+
+void HttpParser::reset() {
+    state_ = State::RequestLine;
+    pos_ = 0;
+    scan_pos_ = 0;
+    method_ = target_ = version_ = body_ = Span{};
+    headers_.clear();
+    content_length_ = 0;
+    chunk_remaining_ = 0;
+    trailers_start_ = 0;
+    chunked_ = false;
+    chunked_body_.clear();
+    request_ = HttpRequest{};
+    error_status_ = 0;
+    error_.clear();
+}
+
+// Поиск конца строки, начиная с места, где остановился предыдущий поиск.
+// Строка возвращается без завершающего CRLF (допускается и голый LF).
+bool HttpParser::next_line(const char* data, size_t size, Span& line) {
+    size_t from = scan_pos_ > pos_ ? scan_pos_ : pos_;
+    const void* nl = from < size ? std::memchr(data + from, '\n', size - from) : nullptr;
+    if (!nl) {
+        scan_pos_ = size;
+        return false;
+    }
+    size_t end = static_cast<const char*>(nl) - data;
+    line.offset = pos_;
+    line.size = end - pos_;
+    if (line.size > 0 && data[end - 1] == '\r') --line.size;
+    pos_ = end + 1;
+    scan_pos_ = pos_;
+    return true;
+}
+
+HttpParser::Result HttpParser::fail(int status, std::string message) {
+    error_status_ = status;
+    error_ = std::move(message);
+    return Result::Error;
+}
+
+HttpParser::Result HttpParser::parse(const char* data, size_t size) {
+    while (true) {
+        Span line;
+        switch (state_) {
+            case State::RequestLine:
+            case State::Headers:
+            case State::Trailers:
+                if (!next_line(data, size, line)) {
+                    size_t start = state_ == State::Trailers ? trailers_start_ : 0;
+                    if (size - start > MAX_HEADER_SIZE) return fail(431, "Request header too large");
+                    return Result::Incomplete;
+                }
+                if (pos_ - (state_ == State::Trailers ? trailers_start_ : 0) > MAX_HEADER_SIZE) {
+                    return fail(431, "Request header too large");
+                }
+                if (state_ == State::RequestLine) {
+                    if (line.size == 0) continue; // пустые строки перед запросом допускаются
+                    if (parse_request_line(data, line) == Result::Error) return Result::Error;
+                    state_ = State::Headers;
+                }
+                else if (state_ == State::Headers) {
+                    if (line.size == 0) {
+                        if (finish_headers(data) == Result::Error) return Result::Error;
+                    }
+                    else if (parse_header_line(data, line) == Result::Error) {
+                        return Result::Error;
+                    }
+                }
+                else if (line.size == 0) {
+                    state_ = State::Done; // трейлеры chunked-тела игнорируются
+                }
+                break;
+
+            case State::Body:
+                if (size - pos_ < content_length_) return Result::Incomplete;
+                body_ = Span{pos_, content_length_};
+                pos_ += content_length_;
+                state_ = State::Done;
+                break;
+
+            case State::ChunkSize: {
+                if (!next_line(data, size, line)) {
+                    if (size - pos_ > 1024) return fail(400, "Invalid chunk size line");
+                    return Result::Incomplete;
+                }
+                std::string_view size_str(data + line.offset, line.size);
+                size_str = trim(size_str.substr(0, size_str.find(';')));
+                size_t chunk_size = 0;
+                if (!parse_hex_size(size_str, chunk_size)) return fail(400, "Invalid chunk size");
+                if (chunked_body_.size() + chunk_size > MAX_BODY_SIZE) return fail(413, "Request body too large");
+                if (pos_ + chunk_size > MAX_REQUEST_SIZE) return fail(413, "Request too large");
+                chunk_remaining_ = chunk_size;
+                if (chunk_size == 0) {
+                    state_ = State::Trailers;
+                    trailers_start_ = pos_;
+                }
+                else {
+                    state_ = State::ChunkData;
+                }
+                break;
+            }
+
+            case State::ChunkData: {
+                size_t available = size - pos_;
+                size_t take = available < chunk_remaining_ ? available : chunk_remaining_;
+                chunked_body_.append(data + pos_, take);
+                pos_ += take;
+                scan_pos_ = pos_;
+                chunk_remaining_ -= take;
+                if (chunk_remaining_ > 0) return Result::Incomplete;
+                state_ = State::ChunkDataEnd;
+                break;
+            }
+
+            case State::ChunkDataEnd:
+                if (!next_line(data, size, line)) {
+                    if (size - pos_ > 2) return fail(400, "Missing CRLF after chunk data");
+                    return Result::Incomplete;
+                }
+                if (line.size != 0) return fail(400, "Missing CRLF after chunk data");
+                state_ = State::ChunkSize;
+                break;
+
+            case State::Done:
+                build_request(data);
+                return Result::Complete;
+        }
+    }
+}
+
+HttpParser::Result HttpParser::parse_request_line(const char* data, Span line) {
+    std::string_view text(data + line.offset, line.size);
+    size_t sp1 = text.find(' ');
+    size_t sp2 = sp1 == std::string_view::npos ? sp1 : text.find(' ', sp1 + 1);
+    if (sp1 == 0 || sp2 == std::string_view::npos || sp2 == sp1 + 1) {
+        return fail(400, "Malformed request line");
+    }
+    method_ = Span{line.offset, sp1};
+    target_ = Span{line.offset + sp1 + 1, sp2 - sp1 - 1};
+    version_ = Span{line.offset + sp2 + 1, line.size - sp2 - 1};
+
+    std::string_view version = text.substr(sp2 + 1);
+    if (version != "HTTP/1.1" && version != "HTTP/1.0") {
+        return fail(505, "HTTP version not supported");
+    }
+    return Result::Incomplete;
+}
+
+HttpParser::Result HttpParser::parse_header_line(const char* data, Span line) {
+    std::string_view text(data + line.offset, line.size);
+    size_t colon = text.find(':');
+    if (colon == 0 || colon == std::string_view::npos) {
+        return fail(400, "Malformed header line");
+    }
+    std::string_view name = text.substr(0, colon);
+    if (name.find_first_of(" \t") != std::string_view::npos) {
+        return fail(400, "Malformed header name");
+    }
+    if (headers_.size() >= MAX_HEADER_COUNT) {
+        return fail(431, "Too many headers");
+    }
+    std::string_view value = trim(text.substr(colon + 1));
+    size_t value_offset = value.empty() ? line.offset + line.size : static_cast<size_t>(value.data() - data);
+    headers_.push_back({Span{line.offset, colon}, Span{value_offset, value.size()}});
+    return Result::Incomplete;
+}
+
+// Конец заголовков: определяем, как читать тело
+HttpParser::Result HttpParser::finish_headers(const char* data) {
+    bool has_length = false;
+    for (const auto& [name, value] : headers_) {
+        std::string_view n(data + name.offset, name.size);
+        std::string_view v(data + value.offset, value.size);
+        if (iequals(n, "Transfer-Encoding")) {
+            if (!has_token(v, "chunked")) return fail(501, "Unsupported transfer encoding");
+            chunked_ = true;
+        }
+        else if (iequals(n, "Content-Length")) {
+            size_t length = 0;
+            if (!parse_size(v, length)) return fail(400, "Invalid Content-Length");
+            if (has_length && length != content_length_) return fail(400, "Conflicting Content-Length");
+            content_length_ = length;
+            has_length = true;
+        }
+    }
+
+    if (chunked_) {
+        state_ = State::ChunkSize;
+    }
+    else if (content_length_ > MAX_BODY_SIZE) {
+        return fail(413, "Request body too large");
+    }
+    else {
+        state_ = content_length_ > 0 ? State::Body : State::Done;
+    }
+    return Result::Incomplete;
+}
+
+void HttpParser::build_request(const char* data) {
+    auto view = [data](Span s) { return std::string_view(data + s.offset, s.size); };
+
+    request_ = HttpRequest{};
+    request_.method = view(method_);
+    request_.target = view(target_);
+    request_.version = view(version_);
+    size_t question = request_.target.find('?');
+    request_.path = request_.target.substr(0, question);
+    if (question != std::string_view::npos) {
+        request_.query = request_.target.substr(question + 1);
+    }
+
+    request_.headers.reserve(headers_.size());
+    for (const auto& [name, value] : headers_) {
+        request_.headers.push_back({view(name), view(value)});
+    }
+    request_.body = chunked_ ? std::string_view(chunked_body_) : view(body_);
+
+    // HTTP/1.1 держит соединение по умолчанию, HTTP/1.0 — только по запросу
+    std::string_view connection = request_.header("Connection");
+    request_.keep_alive = request_.version == "HTTP/1.1"
+        ? !has_token(connection, "close")
+        : has_token(connection, "keep-alive");
+}
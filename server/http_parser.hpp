@@ -0,0 +1,92 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct HttpHeader {
+    std::string_view name;
+    std::string_view value;
+};
+
+// Разобранный HTTP-запрос. Все поля — представления (string_view) в буфер
+// чтения соединения и действительны, пока буфер не изменён.
+struct HttpRequest {
+    std::string_view method;
+    std::string_view target;   // путь вместе со строкой запроса
+    std::string_view path;     // /search
+    std::string_view query;    // brand=Toyota&model=Camry (без '?')
+    std::string_view version;  // HTTP/1.1
+    std::vector<HttpHeader> headers;
+    std::string_view body;
+    bool keep_alive = false;
+
+    // Значение заголовка (имя без учёта регистра), пустое если заголовка нет
+    std::string_view header(std::string_view name) const;
+};
+
+// Инкрементальный парсер HTTP/1.1-запросов. parse() вызывается каждый раз,
+// когда в буфер соединения дочитаны новые данные; парсер хранит позицию и
+// продолжает разбор с места остановки, не просматривая байты повторно.
+// Парсер хранит смещения, а не указатели, поэтому буфер между вызовами
+// можно расширять (перевыделять).
+// Тело с Content-Length отдаётся представлением в буфер без копирования,
+// chunked-тело собирается во внутренний буфер парсера.
+class HttpParser {
+public:
+    enum class Result { Complete, Incomplete, Error };
+
+    static constexpr size_t MAX_HEADER_SIZE = 64 * 1024;
+    static constexpr size_t MAX_HEADER_COUNT = 100;
+    static constexpr size_t MAX_BODY_SIZE = 16 * 1024 * 1024;
+    // Предел всего запроса вместе с разметкой chunked-тела и трейлерами:
+    // иначе мелкие чанки держат в буфере соединения кратно больше тела
+    static constexpr size_t MAX_REQUEST_SIZE = MAX_HEADER_SIZE + MAX_BODY_SIZE;
+
+    // data/size — все непрочитанные байты соединения, начиная с текущего запроса
+    Result parse(const char* data, size_t size);
+
+    // Результат последнего успешного разбора (после Result::Complete)
+    const HttpRequest& request() const { return request_; }
+    // Сколько байт буфера занимает разобранный запрос
+    size_t consumed() const { return pos_; }
+
+    // HTTP-статус и описание ошибки (после Result::Error)
+    int error_status() const { return error_status_; }
+    const std::string& error() const { return error_; }
+
+    // Подготовка к разбору следующего запроса
+    void reset();
+
+private:
+    struct Span {
+        size_t offset = 0;
+        size_t size = 0;
+    };
+
+    enum class State { RequestLine, Headers, Body, ChunkSize, ChunkData, ChunkDataEnd, Trailers, Done };
+
+    bool next_line(const char* data, size_t size, Span& line);
+    Result fail(int status, std::string message);
+    Result parse_request_line(const char* data, Span line);
+    Result parse_header_line(const char* data, Span line);
+    Result finish_headers(const char* data);
+    void build_request(const char* data);
+
+    State state_ = State::RequestLine;
+    size_t pos_ = 0;       // начало ещё не разобранных данных
+    size_t scan_pos_ = 0;  // докуда уже искался конец текущей строки
+
+    Span method_, target_, version_;
+    std::vector<std::pair<Span, Span>> headers_;
+    Span body_;
+    size_t content_length_ = 0;
+    size_t chunk_remaining_ = 0;
+    size_t trailers_start_ = 0;  // трейлеры ограничены MAX_HEADER_SIZE, как и заголовки
+    bool chunked_ = false;
+    std::string chunked_body_;
+
+    HttpRequest request_;
+    int error_status_ = 0;
+    std::string error_;
+};
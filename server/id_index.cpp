@@ -0,0 +1,77 @@
+#include "id_index.hpp"
+#include <algorithm>
+#include <climits>
+
+size_t IdIndex::home(int32_t id) const {
+    // Мультипликативное хеширование: соседние id расходятся по таблице
+    uint64_t hash = static_cast<uint32_t>(id) * 0x9E3779B97F4A7C15ull;
+    return static_cast<size_t>(hash >> 32) & (entries_.size() - 1);
+}
+
+std::optional<uint32_t> IdIndex::find(int32_t id) const {
+    if (entries_.empty()) return std::nullopt;
+    const size_t mask = entries_.size() - 1;
+    for (size_t i = home(id);; i = (i + 1) & mask) {
+        const Entry& entry = entries_[i];
+        if (entry.slot == EMPTY) return std::nullopt;
+        if (entry.id == id) return entry.slot;
+    }
+}
+
+bool IdIndex::insert(int32_t id, uint32_t slot) {
+    if ((size_ + 1) * 2 > entries_.size()) grow();
+    if (id >= next_id_ && id < INT32_MAX) next_id_ = id + 1;
+
+    const size_t mask = entries_.size() - 1;
+    for (size_t i = home(id);; i = (i + 1) & mask) {
+        Entry& entry = entries_[i];
+        if (entry.slot == EMPTY) {
+            entry = {id, slot};
+            ++size_;
+            return true;
+        }
+        if (entry.id == id) return false;
+    }
+}
+
+bool IdIndex::erase(int32_t id) {
+    if (entries_.empty()) return false;
+    const size_t mask = entries_.size() - 1;
+    size_t hole = home(id);
+    for (;; hole = (hole + 1) & mask) {
+        if (entries_[hole].slot == EMPTY) return false;
+        if (entries_[hole].id == id) break;
+    }
+
+    // Обратный сдвиг: записи цепочки за дыркой, которые могут в неё встать,
+    // переезжают назад, чтобы поиск не обрывался на пустой ячейке
+    for (size_t i = (hole + 1) & mask; entries_[i].slot != EMPTY; i = (i + 1) & mask) {
+        size_t wanted = home(entries_[i].id);
+        // Запись остаётся, если её место лежит циклически в (hole, i]
+        bool stays = hole <= i ? (hole < wanted && wanted <= i) : (hole < wanted || wanted <= i);
+        if (stays) continue;
+        entries_[hole] = entries_[i];
+        hole = i;
+    }
+    entries_[hole] = Entry();
+    --size_;
+    return true;
+}
+
+void IdIndex::shift_after(uint32_t slot) {
+    for (auto& entry : entries_) {
+        if (entry.slot != EMPTY && entry.slot > slot) --entry.slot;
+    }
+}
+
+void IdIndex::grow() {
+    std::vector<Entry> old = std::move(entries_);
+    entries_.assign(std::max<size_t>(old.size() * 2, 16), Entry());
+    const size_t mask = entries_.size() - 1;
+    for (const auto& entry : old) {
+        if (entry.slot == EMPTY) continue;
+        size_t i = home(entry.id);
+        while (entries_[i].slot != EMPTY) i = (i + 1) & mask;
+        entries_[i] = entry;
+    }
+}
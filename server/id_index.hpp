@@ -0,0 +1,45 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+// Индекс id -> позиция записи в наборе (автомобили, города, документы) и
+// выдача id новых записей. Открытая адресация с линейным пробированием в
+// таблице размером степень двойки, заполненной не больше чем наполовину;
+// удаление — обратным сдвигом, без надгробий. Новые id растут монотонно:
+// next_id() больше любого id, который был в индексе, поэтому id удалённой
+// записи не достаётся новой.
+class IdIndex {
+public:
+    std::optional<uint32_t> find(int32_t id) const;
+
+    // Запись с id в позиции slot; повторный id не заменяет первый (false)
+    bool insert(int32_t id, uint32_t slot);
+    bool erase(int32_t id);
+    // Позиции за удалённой из набора позицией slot сдвигаются на одну назад
+    void shift_after(uint32_t slot);
+
+    int32_t next_id() const { return next_id_; }
+    // Выдача id новой записи
+    int32_t allocate() { return next_id_++; }
+    // Следующие id — не меньше next_id (восстановление счётчика из снимка)
+    void reserve_ids(int32_t next_id) { if (next_id > next_id_) next_id_ = next_id; }
+
+    size_t size() const { return size_; }
+
+private:
+    static constexpr uint32_t EMPTY = UINT32_MAX;
+
+    struct Entry {
+        int32_t id = 0;
+        uint32_t slot = EMPTY;
+    };
+
+    size_t home(int32_t id) const;
+    void grow();
+
+    std::vector<Entry> entries_;
+    size_t size_ = 0;
+    int32_t next_id_ = 1;
+};
@@ -0,0 +1,96 @@
+#pragma once
+#include "router.hpp"
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+// Кэш готового ответа одного эндпоинта. Ответ действителен для одной версии
+// набора данных: админские изменения публикуют новую версию каталога, и
+// следующий запрос пересобирает ответ. Чтение кэша не берёт блокировок;
+// если ответ одновременно пересоберут два потока, победит любой из них.
+class ResponseCache {
+public:
+    struct Entry {
+        uint64_t version = 0;
+        std::string etag;
+        std::shared_ptr<const PreparedResponse> response;     // 200 с телом и ETag
+        std::shared_ptr<const PreparedResponse> not_modified; // 304 для If-None-Match
+    };
+
+    // build() возвращает тело ответа и вызывается только при смене версии
+    template<class F>
+    std::shared_ptr<const Entry> get(uint64_t version, F&& build) {
+        auto entry = std::atomic_load(&entry_);
+        if (entry && entry->version == version) {
+            return entry;
+        }
+        auto fresh = std::make_shared<Entry>();
+        fresh->version = version;
+        std::string body = build();
+        fresh->etag = make_etag(body);
+        fresh->response = PreparedResponse::make(200, body, fresh->etag);
+        fresh->not_modified = PreparedResponse::not_modified(fresh->etag);
+        entry = fresh;
+        std::atomic_store(&entry_, entry);
+        return entry;
+    }
+
+    // Ответ на условный GET: 304, если клиент уже имеет эту версию
+    template<class F>
+    std::shared_ptr<const PreparedResponse> respond(const HttpRequest& request, uint64_t version, F&& build) {
+        auto entry = get(version, std::forward<F>(build));
+        if (etag_matches(request.header("If-None-Match"), entry->etag)) {
+            return entry->not_modified;
+        }
+        return entry->response;
+    }
+
+private:
+    std::shared_ptr<const Entry> entry_;
+};
+
+// Кэши ответа эндпоинта по строке запроса (например, /cars?fields=...) с
+// вытеснением строки, которую дольше всех не запрашивали (LRU). Редкие и
+// случайные строки запроса не занимают места навсегда, а частые остаются в
+// кэше; готовых ответов в памяти не больше capacity.
+class QueryResponseCache {
+public:
+    explicit QueryResponseCache(size_t capacity) : capacity_(capacity) {}
+
+    // Кэш для строки запроса; новая строка вытесняет самую давнюю
+    std::shared_ptr<ResponseCache> get(std::string_view query) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = index_.find(query);
+        if (it != index_.end()) {
+            order_.splice(order_.begin(), order_, it->second);
+            return it->second->second;
+        }
+        order_.emplace_front(std::string(query), std::make_shared<ResponseCache>());
+        // Ключ индекса ссылается на строку в узле списка: узлы не перемещаются
+        index_.emplace(order_.front().first, order_.begin());
+        if (order_.size() > capacity_) {
+            index_.erase(order_.back().first);
+            order_.pop_back();
+        }
+        return order_.front().second;
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return order_.size();
+    }
+
+private:
+    using Entries = std::list<std::pair<std::string, std::shared_ptr<ResponseCache>>>;
+
+    size_t capacity_;
+    mutable std::mutex mutex_;
+    Entries order_; // от недавно запрошенных к давним
+    std::unordered_map<std::string_view, Entries::iterator> index_;
+};
@@ -0,0 +1,323 @@
+#include "roaring.hpp"
+#include <algorithm>
+#include <cstddef>
+
+namespace {
+
+uint32_t popcount(const std::vector<uint64_t>& words) {
+    uint32_t total = 0;
+    for (uint64_t word : words) total += static_cast<uint32_t>(__builtin_popcountll(word));
+    return total;
+}
+
+bool test_bit(const std::vector<uint64_t>& bits, uint16_t low) {
+    return (bits[low / 64] >> (low % 64)) & 1;
+}
+
+} // namespace
+
+// === Container ===
+
+bool RoaringBitmap::Container::contains(uint16_t low) const {
+    if (is_bitmap()) return test_bit(bits, low);
+    return std::binary_search(array.begin(), array.end(), low);
+}
+
+void RoaringBitmap::Container::add(uint16_t low) {
+    if (is_bitmap()) {
+        uint64_t mask = uint64_t(1) << (low % 64);
+        if (!(bits[low / 64] & mask)) {
+            bits[low / 64] |= mask;
+            ++cardinality;
+        }
+        return;
+    }
+    // Значения обычно добавляются по возрастанию — тогда вставка в конец
+    if (array.empty() || array.back() < low) {
+        array.push_back(low);
+    }
+    else {
+        auto it = std::lower_bound(array.begin(), array.end(), low);
+        if (*it == low) return;
+        array.insert(it, low);
+    }
+    ++cardinality;
+    if (array.size() > ARRAY_LIMIT) to_bitmap();
+}
+
+void RoaringBitmap::Container::remove(uint16_t low) {
+    if (is_bitmap()) {
+        uint64_t mask = uint64_t(1) << (low % 64);
+        if (bits[low / 64] & mask) {
+            bits[low / 64] &= ~mask;
+            --cardinality;
+            if (cardinality <= ARRAY_LIMIT) to_array();
+        }
+        return;
+    }
+    auto it = std::lower_bound(array.begin(), array.end(), low);
+    if (it != array.end() && *it == low) {
+        array.erase(it);
+        --cardinality;
+    }
+}
+
+void RoaringBitmap::Container::shift_down(uint16_t from) {
+    if (is_bitmap()) {
+        if (test_bit(bits, from)) --cardinality;
+        // Биты выше from сдвигаются на один вниз, младший бит следующего
+        // слова переходит в старший бит предыдущего
+        size_t first = from / 64;
+        uint64_t keep = (uint64_t(1) << (from % 64)) - 1;
+        for (size_t w = first; w < bits.size(); ++w) {
+            uint64_t next = w + 1 < bits.size() ? bits[w + 1] & 1 : 0;
+            uint64_t shifted = (bits[w] >> 1) | (next << 63);
+            bits[w] = w == first ? (bits[w] & keep) | (shifted & ~keep) : shifted;
+        }
+        if (cardinality <= ARRAY_LIMIT) to_array();
+        return;
+    }
+    auto it = std::lower_bound(array.begin(), array.end(), from);
+    if (it != array.end() && *it == from) {
+        it = array.erase(it);
+        --cardinality;
+    }
+    for (; it != array.end(); ++it) --*it;
+}
+
+void RoaringBitmap::Container::to_bitmap() {
+    bits.assign(BITMAP_WORDS, 0);
+    for (uint16_t low : array) bits[low / 64] |= uint64_t(1) << (low % 64);
+    array.clear();
+    array.shrink_to_fit();
+}
+
+void RoaringBitmap::Container::to_array() {
+    array.clear();
+    array.reserve(cardinality);
+    for (size_t w = 0; w < bits.size(); ++w) {
+        uint64_t word = bits[w];
+        while (word) {
+            array.push_back(static_cast<uint16_t>(w * 64 + static_cast<size_t>(__builtin_ctzll(word))));
+            word &= word - 1;
+        }
+    }
+    bits.clear();
+    bits.shrink_to_fit();
+}
+
+// === RoaringBitmap ===
+
+RoaringBitmap RoaringBitmap::from_sorted(const std::vector<uint32_t>& values) {
+    RoaringBitmap result;
+    for (uint32_t value : values) result.add(value);
+    return result;
+}
+
+const RoaringBitmap::Container* RoaringBitmap::find(uint16_t key) const {
+    auto it = std::lower_bound(containers_.begin(), containers_.end(), key,
+        [](const Container& c, uint16_t k) { return c.key < k; });
+    return it != containers_.end() && it->key == key ? &*it : nullptr;
+}
+
+RoaringBitmap::Container& RoaringBitmap::get_or_create(uint16_t key) {
+    if (!containers_.empty() && containers_.back().key == key) return containers_.back();
+    auto it = std::lower_bound(containers_.begin(), containers_.end(), key,
+        [](const Container& c, uint16_t k) { return c.key < k; });
+    if (it != containers_.end() && it->key == key) return *it;
+    Container container;
+    container.key = key;
+    return *containers_.insert(it, std::move(container));
+}
+
+void RoaringBitmap::add(uint32_t value) {
+    get_or_create(static_cast<uint16_t>(value >> 16)).add(static_cast<uint16_t>(value));
+}
+
+void RoaringBitmap::remove(uint32_t value) {
+    uint16_t key = static_cast<uint16_t>(value >> 16);
+    auto it = std::lower_bound(containers_.begin(), containers_.end(), key,
+        [](const Container& c, uint16_t k) { return c.key < k; });
+    if (it == containers_.end() || it->key != key) return;
+    it->remove(static_cast<uint16_t>(value));
+    if (it->cardinality == 0) containers_.erase(it);
+}
+
+bool RoaringBitmap::contains(uint32_t value) const {
+    const Container* container = find(static_cast<uint16_t>(value >> 16));
+    return container && container->contains(static_cast<uint16_t>(value));
+}
+
+uint64_t RoaringBitmap::cardinality() const {
+    uint64_t total = 0;
+    for (const auto& container : containers_) total += container.cardinality;
+    return total;
+}
+
+void RoaringBitmap::remove_and_shift(uint32_t value) {
+    uint16_t key = static_cast<uint16_t>(value >> 16);
+    // Блоки, где все значения меньше value, не меняются
+    size_t i = static_cast<size_t>(std::lower_bound(containers_.begin(), containers_.end(), key,
+        [](const Container& c, uint16_t k) { return c.key < k; }) - containers_.begin());
+    bool emptied = false;
+    for (; i < containers_.size(); ++i) {
+        Container& container = containers_[i];
+        if (container.key == key) {
+            container.shift_down(static_cast<uint16_t>(value));
+        }
+        else {
+            // Наименьшее значение блока переходит в конец предыдущего блока
+            bool carry = container.contains(0);
+            container.shift_down(0);
+            if (carry) {
+                uint16_t previous = static_cast<uint16_t>(container.key - 1);
+                if (i == 0 || containers_[i - 1].key != previous) {
+                    Container created;
+                    created.key = previous;
+                    containers_.insert(containers_.begin() + static_cast<std::ptrdiff_t>(i), std::move(created));
+                    ++i;
+                }
+                containers_[i - 1].add(0xFFFF);
+            }
+        }
+        emptied = emptied || containers_[i].cardinality == 0;
+    }
+    if (emptied) {
+        containers_.erase(std::remove_if(containers_.begin(), containers_.end(),
+            [](const Container& c) { return c.cardinality == 0; }), containers_.end());
+    }
+}
+
+std::vector<uint32_t> RoaringBitmap::to_vector() const {
+    std::vector<uint32_t> values;
+    values.reserve(cardinality());
+    for_each([&](uint32_t value) { values.push_back(value); });
+    return values;
+}
+
+RoaringBitmap::Container RoaringBitmap::and_containers(const Container& a, const Container& b) {
+    Container result;
+    result.key = a.key;
+    if (a.is_bitmap() && b.is_bitmap()) {
+        result.bits.resize(BITMAP_WORDS);
+        for (size_t w = 0; w < BITMAP_WORDS; ++w) result.bits[w] = a.bits[w] & b.bits[w];
+        result.cardinality = popcount(result.bits);
+        if (result.cardinality <= ARRAY_LIMIT) result.to_array();
+        return result;
+    }
+    if (a.is_bitmap() || b.is_bitmap()) {
+        const Container& array = a.is_bitmap() ? b : a;
+        const Container& bitmap = a.is_bitmap() ? a : b;
+        for (uint16_t low : array.array) {
+            if (test_bit(bitmap.bits, low)) result.array.push_back(low);
+        }
+    }
+    else {
+        std::set_intersection(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(),
+                              std::back_inserter(result.array));
+    }
+    result.cardinality = static_cast<uint32_t>(result.array.size());
+    return result;
+}
+
+uint32_t RoaringBitmap::and_container_cardinality(const Container& a, const Container& b) {
+    if (a.is_bitmap() && b.is_bitmap()) {
+        uint32_t total = 0;
+        for (size_t w = 0; w < BITMAP_WORDS; ++w) {
+            total += static_cast<uint32_t>(__builtin_popcountll(a.bits[w] & b.bits[w]));
+        }
+        return total;
+    }
+    if (a.is_bitmap() || b.is_bitmap()) {
+        const Container& array = a.is_bitmap() ? b : a;
+        const Container& bitmap = a.is_bitmap() ? a : b;
+        uint32_t total = 0;
+        for (uint16_t low : array.array) total += test_bit(bitmap.bits, low);
+        return total;
+    }
+    uint32_t total = 0;
+    auto i = a.array.begin();
+    auto j = b.array.begin();
+    while (i != a.array.end() && j != b.array.end()) {
+        if (*i < *j) ++i;
+        else if (*j < *i) ++j;
+        else { ++total; ++i; ++j; }
+    }
+    return total;
+}
+
+RoaringBitmap::Container RoaringBitmap::or_containers(const Container& a, const Container& b) {
+    Container result;
+    result.key = a.key;
+    if (a.is_bitmap() || b.is_bitmap()) {
+        result.bits.assign(BITMAP_WORDS, 0);
+        for (const Container* c : {&a, &b}) {
+            if (c->is_bitmap()) {
+                for (size_t w = 0; w < BITMAP_WORDS; ++w) result.bits[w] |= c->bits[w];
+            }
+            else {
+                for (uint16_t low : c->array) result.bits[low / 64] |= uint64_t(1) << (low % 64);
+            }
+        }
+        result.cardinality = popcount(result.bits);
+        return result;
+    }
+    std::set_union(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(),
+                   std::back_inserter(result.array));
+    result.cardinality = static_cast<uint32_t>(result.array.size());
+    if (result.array.size() > ARRAY_LIMIT) result.to_bitmap();
+    return result;
+}
+
+RoaringBitmap RoaringBitmap::operator&(const RoaringBitmap& other) const {
+    RoaringBitmap result;
+    auto i = containers_.begin();
+    auto j = other.containers_.begin();
+    while (i != containers_.end() && j != other.containers_.end()) {
+        if (i->key < j->key) ++i;
+        else if (j->key < i->key) ++j;
+        else {
+            Container container = and_containers(*i, *j);
+            if (container.cardinality > 0) result.containers_.push_back(std::move(container));
+            ++i;
+            ++j;
+        }
+    }
+    return result;
+}
+
+RoaringBitmap RoaringBitmap::operator|(const RoaringBitmap& other) const {
+    RoaringBitmap result;
+    auto i = containers_.begin();
+    auto j = other.containers_.begin();
+    while (i != containers_.end() || j != other.containers_.end()) {
+        if (j == other.containers_.end() || (i != containers_.end() && i->key < j->key)) {
+            result.containers_.push_back(*i++);
+        }
+        else if (i == containers_.end() || j->key < i->key) {
+            result.containers_.push_back(*j++);
+        }
+        else {
+            result.containers_.push_back(or_containers(*i, *j));
+            ++i;
+            ++j;
+        }
+    }
+    return result;
+}
+
+uint64_t RoaringBitmap::and_cardinality(const RoaringBitmap& a, const RoaringBitmap& b) {
+    uint64_t total = 0;
+    auto i = a.containers_.begin();
+    auto j = b.containers_.begin();
+    while (i != a.containers_.end() && j != b.containers_.end()) {
+        if (i->key < j->key) ++i;
+        else if (j->key < i->key) ++j;
+        else {
+            total += and_container_cardinality(*i, *j);
+            ++i;
+            ++j;
+        }
+    }
+    return total;
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Сжатая битовая карта в духе Roaring: множество uint32 делится на блоки по
+// старшим 16 битам. Разреженный блок хранит отсортированный массив младших
+// 16 бит (до 4096 значений), плотный — 65536 бит (1024 слова). Пересечение
+// и объединение работают поблочно, мощность плотных блоков считается popcount.
+class RoaringBitmap {
+public:
+    static RoaringBitmap from_sorted(const std::vector<uint32_t>& values);
+
+    void add(uint32_t value);
+    void remove(uint32_t value);
+    bool contains(uint32_t value) const;
+
+    uint64_t cardinality() const;
+    bool empty() const { return containers_.empty(); }
+
+    // Удаление value со сдвигом всех больших значений на 1 вниз
+    // (строка удалена из хранилища, последующие позиции сдвигаются).
+    // Блоки сдвигаются на месте без выделения памяти; между соседними
+    // блоками переносится только младшее значение.
+    void remove_and_shift(uint32_t value);
+
+    std::vector<uint32_t> to_vector() const;
+
+    // Обход значений по возрастанию
+    template<class F>
+    void for_each(F&& f) const {
+        for (const auto& container : containers_) {
+            uint32_t high = static_cast<uint32_t>(container.key) << 16;
+            if (container.is_bitmap()) {
+                for (size_t w = 0; w < container.bits.size(); ++w) {
+                    uint64_t word = container.bits[w];
+                    while (word) {
+                        f(high | static_cast<uint32_t>(w * 64 + static_cast<size_t>(__builtin_ctzll(word))));
+                        word &= word - 1;
+                    }
+                }
+            }
+            else {
+                for (uint16_t low : container.array) f(high | low);
+            }
+        }
+    }
+
+    RoaringBitmap operator&(const RoaringBitmap& other) const;
+    RoaringBitmap operator|(const RoaringBitmap& other) const;
+    // Мощность пересечения без построения результата
+    static uint64_t and_cardinality(const RoaringBitmap& a, const RoaringBitmap& b);
+
+    bool operator==(const RoaringBitmap& other) const { return to_vector() == other.to_vector(); }
+
+private:
+    // Массив переводится в битовую карту, когда перестаёт быть компактнее неё
+    static constexpr size_t ARRAY_LIMIT = 4096;
+    static constexpr size_t BITMAP_WORDS = 1024;
+
+    struct Container {
+        uint16_t key = 0;
+        uint32_t cardinality = 0;
+        std::vector<uint16_t> array; // разреженный блок
+        std::vector<uint64_t> bits;  // плотный блок (BITMAP_WORDS слов)
+
+        bool is_bitmap() const { return !bits.empty(); }
+        bool contains(uint16_t low) const;
+        void add(uint16_t low);
+        void remove(uint16_t low);
+        // Удаление from и сдвиг больших значений на 1 вниз на месте
+        void shift_down(uint16_t from);
+        void to_bitmap();
+        void to_array();
+    };
+
+    static Container and_containers(const Container& a, const Container& b);
+    static Container or_containers(const Container& a, const Container& b);
+    static uint32_t and_container_cardinality(const Container& a, const Container& b);
+
+    // Блок с ключом key или nullptr
+    const Container* find(uint16_t key) const;
+    Container& get_or_create(uint16_t key);
+
+    std::vector<Container> containers_; // по возрастанию key
+};
@@ -0,0 +1,232 @@
+#include "router.hpp"
+#include "../common/json.hpp"
+#include <charconv>
+#include <cstdint>
+#include <stdexcept>
+
+using json = nlohmann::json;
+
+namespace {
+
+// Обход сегментов пути без копирования; пустые сегменты ("//", хвостовой "/") пропускаются
+template<class F>
+void for_each_segment(std::string_view path, F&& f) {
+    while (!path.empty()) {
+        size_t slash = path.find('/');
+        std::string_view segment = path.substr(0, slash);
+        if (!segment.empty() && !f(segment)) return;
+        if (slash == std::string_view::npos) break;
+        path.remove_prefix(slash + 1);
+    }
+}
+
+const char* status_text(int status) {
+    switch (status) {
+        case 200: return "OK";
+        case 304: return "Not Modified";
+        case 400: return "Bad Request";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 413: return "Payload Too Large";
+        case 431: return "Request Header Fields Too Large";
+        case 501: return "Not Implemented";
+        case 505: return "HTTP Version Not Supported";
+        default: return "Error";
+    }
+}
+
+} // namespace
+
+std::shared_ptr<const PreparedResponse> PreparedResponse::make(int status, std::string_view body,
+                                                               std::string_view etag) {
+    auto response = std::make_shared<PreparedResponse>();
+    std::string& bytes = response->bytes;
+    bytes.reserve(body.size() + 128);
+    bytes.append("HTTP/1.1 ").append(std::to_string(status)).append(" ").append(status_text(status)).append("\r\n");
+    bytes.append("Content-Type: application/json\r\n");
+    if (!etag.empty()) {
+        bytes.append("ETag: ").append(etag).append("\r\n");
+    }
+    bytes.append("Content-Length: ").append(std::to_string(body.size())).append("\r\n");
+    response->head_size = bytes.size();
+    bytes.append(body);
+    return response;
+}
+
+std::shared_ptr<const PreparedResponse> PreparedResponse::not_modified(std::string_view etag) {
+    auto response = std::make_shared<PreparedResponse>();
+    response->bytes.append("HTTP/1.1 304 Not Modified\r\n");
+    response->bytes.append("ETag: ").append(etag).append("\r\n");
+    response->head_size = response->bytes.size();
+    return response;
+}
+
+std::string make_etag(std::string_view body) {
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : body) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    static const char digits[] = "0123456789abcdef";
+    std::string etag(18, '"');
+    for (int i = 16; i >= 1; --i) {
+        etag[i] = digits[hash & 0xf];
+        hash >>= 4;
+    }
+    return etag;
+}
+
+bool etag_matches(std::string_view if_none_match, std::string_view etag) {
+    while (!if_none_match.empty()) {
+        size_t comma = if_none_match.find(',');
+        std::string_view tag = if_none_match.substr(0, comma);
+        size_t begin = tag.find_first_not_of(" \t");
+        size_t end = tag.find_last_not_of(" \t");
+        if (begin != std::string_view::npos) {
+            tag = tag.substr(begin, end - begin + 1);
+            if (tag == "*") return true;
+            if (tag.substr(0, 2) == "W/") tag.remove_prefix(2);
+            if (tag == etag) return true;
+        }
+        if (comma == std::string_view::npos) break;
+        if_none_match.remove_prefix(comma + 1);
+    }
+    return false;
+}
+
+HttpResponse HttpResponse::error(int status, std::string_view message) {
+    return {status, json{{"error", message}}.dump(), nullptr};
+}
+
+std::string_view RouteParams::get(std::string_view name) const {
+    for (const auto& p : params_) {
+        if (p.name == name) return p.value;
+    }
+    return {};
+}
+
+int RouteParams::get_int(std::string_view name) const {
+    for (const auto& p : params_) {
+        if (p.name == name) return p.int_value;
+    }
+    return 0;
+}
+
+Router::Router() : root_(std::make_unique<Node>()) {}
+Router::~Router() = default;
+
+int Router::method_index(std::string_view method) {
+    if (method == "GET") return 0;
+    if (method == "POST") return 1;
+    if (method == "PUT") return 2;
+    if (method == "DELETE") return 3;
+    return -1;
+}
+
+void Router::add(std::string_view method, std::string_view pattern, RouteHandler handler,
+                 bool blocking) {
+    int index = method_index(method);
+    if (index < 0) {
+        throw std::invalid_argument("Unsupported method in route: " + std::string(method));
+    }
+
+    Node* node = root_.get();
+    for_each_segment(pattern, [&](std::string_view segment) {
+        if (segment.front() == '{' && segment.back() == '}') {
+            std::string_view spec = segment.substr(1, segment.size() - 2);
+            size_t colon = spec.find(':');
+            std::string name(spec.substr(0, colon));
+            ParamType type = ParamType::String;
+            if (colon != std::string_view::npos) {
+                std::string_view type_name = spec.substr(colon + 1);
+                if (type_name == "int") type = ParamType::Int;
+                else if (type_name != "string") {
+                    throw std::invalid_argument("Unknown parameter type in route: " + std::string(pattern));
+                }
+            }
+            if (!node->param_child) {
+                node->param_child = std::make_unique<Node>();
+                node->param_name = name;
+                node->param_type = type;
+            }
+            else if (node->param_name != name || node->param_type != type) {
+                throw std::invalid_argument("Conflicting parameter in route: " + std::string(pattern));
+            }
+            node = node->param_child.get();
+        }
+        else {
+            auto& child = node->children[std::string(segment)];
+            if (!child) child = std::make_unique<Node>();
+            node = child.get();
+        }
+        return true;
+    });
+
+    if (node->handlers[index]) {
+        throw std::invalid_argument("Duplicate route: " + std::string(method) + " " + std::string(pattern));
+    }
+    node->handlers[index] = std::move(handler);
+    node->blocking[index] = blocking;
+}
+
+const Router::Node* Router::match(std::string_view path, RouteParams& params, std::string_view& bad_param) const {
+    const Node* node = root_.get();
+    std::string key; // переиспользуемый ключ для поиска в unordered_map
+
+    for_each_segment(path, [&](std::string_view segment) {
+        key.assign(segment.data(), segment.size());
+        auto it = node->children.find(key);
+        if (it != node->children.end()) {
+            node = it->second.get();
+            return true;
+        }
+        if (!node->param_child) {
+            node = nullptr;
+            return false;
+        }
+
+        RouteParams::Param param{node->param_name, segment, 0};
+        if (node->param_type == ParamType::Int) {
+            auto [end, ec] = std::from_chars(segment.data(), segment.data() + segment.size(), param.int_value);
+            if (ec != std::errc() || end != segment.data() + segment.size()) {
+                bad_param = node->param_name;
+                node = nullptr;
+                return false;
+            }
+        }
+        params.params_.push_back(param);
+        node = node->param_child.get();
+        return true;
+    });
+    return node;
+}
+
+HttpResponse Router::dispatch(const HttpRequest& request) const {
+    RouteParams params;
+    std::string_view bad_param;
+    const Node* node = match(request.path, params, bad_param);
+
+    if (!bad_param.empty()) {
+        return HttpResponse::error(400, "Invalid parameter " + std::string(bad_param) + ": expected integer");
+    }
+    if (!node) {
+        return HttpResponse::error(404, "Not found: " + std::string(request.path));
+    }
+
+    int index = method_index(request.method);
+    if (index < 0 || !node->handlers[index]) {
+        bool any = false;
+        for (const auto& h : node->handlers) any = any || static_cast<bool>(h);
+        if (!any) return HttpResponse::error(404, "Not found: " + std::string(request.path));
+        return HttpResponse::error(405, "Method not allowed: " + std::string(request.method));
+    }
+    return node->handlers[index](request, params);
+}
+
+bool Router::blocking(const HttpRequest& request) const {
+    RouteParams params;
+    std::string_view bad_param;
+    const Node* node = match(request.path, params, bad_param);
+    int index = method_index(request.method);
+    return node && index >= 0 && node->blocking[index];
+}
@@ -0,0 +1,109 @@
+#pragma once
+#include "http_parser.hpp"
+#include <array>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Сериализованный HTTP-ответ: строка статуса с заголовками (кроме Connection,
+// который зависит от соединения) и тело в одном буфере. Такой ответ можно
+// кэшировать и отправлять разным клиентам без копирования.
+struct PreparedResponse {
+    std::string bytes;
+    size_t head_size = 0; // bytes[0, head_size) — заголовки, дальше тело
+
+    std::string_view head() const { return std::string_view(bytes).substr(0, head_size); }
+    std::string_view body() const { return std::string_view(bytes).substr(head_size); }
+
+    // etag (если задан) добавляется заголовком ETag
+    static std::shared_ptr<const PreparedResponse> make(int status, std::string_view body,
+                                                        std::string_view etag = {});
+    // 304 Not Modified без тела
+    static std::shared_ptr<const PreparedResponse> not_modified(std::string_view etag);
+};
+
+// Сильный ETag по содержимому тела: "<64-битный FNV-1a в hex>". Хэш, а не
+// номер версии каталога, чтобы ETag не повторялся после перезапуска сервера.
+std::string make_etag(std::string_view body);
+
+// Совпадает ли etag с одним из значений If-None-Match ("*", список через
+// запятую, слабые W/"..." сравниваются без учёта префикса)
+bool etag_matches(std::string_view if_none_match, std::string_view etag);
+
+// Ответ обработчика маршрута
+struct HttpResponse {
+    int status = 200;
+    std::string body;
+    std::shared_ptr<const PreparedResponse> prepared; // если задан, отправляется как есть
+
+    static HttpResponse ok(std::string body) { return {200, std::move(body), nullptr}; }
+    // Ответ с JSON-телом {"error": message}
+    static HttpResponse error(int status, std::string_view message);
+    static HttpResponse from(std::shared_ptr<const PreparedResponse> prepared) {
+        return {200, {}, std::move(prepared)};
+    }
+};
+
+// Параметры пути, извлечённые при сопоставлении: /admin/cars/{id:int}
+class RouteParams {
+public:
+    struct Param {
+        std::string_view name;
+        std::string_view value;
+        int int_value = 0; // для параметров типа int
+    };
+
+    std::string_view get(std::string_view name) const;
+    int get_int(std::string_view name) const;
+
+private:
+    friend class Router;
+    std::vector<Param> params_;
+};
+
+using RouteHandler = std::function<HttpResponse(const HttpRequest&, const RouteParams&)>;
+
+// Таблица маршрутов (метод + шаблон пути -> обработчик), строится один раз
+// при старте. Шаблоны хранятся в префиксном дереве по сегментам пути,
+// поэтому стоимость поиска зависит от глубины пути, а не от числа маршрутов.
+// Статические сегменты имеют приоритет над параметрами.
+class Router {
+public:
+    Router();
+    ~Router();
+
+    // pattern: "/cars", "/admin/cars/{id:int}", "/files/{name}".
+    // blocking — обработчик ждёт ввода-вывода (например, fsync журнала), и
+    // сервер выполняет его вне потоков, обслуживающих соединения
+    void add(std::string_view method, std::string_view pattern, RouteHandler handler,
+             bool blocking = false);
+
+    // 404 — путь не найден, 405 — метод не поддерживается,
+    // 400 — параметр пути не соответствует типу
+    HttpResponse dispatch(const HttpRequest& request) const;
+    // Запрос попадает в обработчик, добавленный с blocking = true
+    bool blocking(const HttpRequest& request) const;
+
+private:
+    enum class ParamType { String, Int };
+    static constexpr size_t METHOD_COUNT = 4; // GET, POST, PUT, DELETE
+
+    struct Node {
+        std::unordered_map<std::string, std::unique_ptr<Node>> children;
+        std::unique_ptr<Node> param_child;
+        std::string param_name;
+        ParamType param_type = ParamType::String;
+        std::array<RouteHandler, METHOD_COUNT> handlers;
+        std::array<bool, METHOD_COUNT> blocking{};
+    };
+
+    static int method_index(std::string_view method);
+    // Узел шаблона для пути запроса; nullptr — путь не найден или параметр
+    // не разобран (тогда его имя в bad_param)
+    const Node* match(std::string_view path, RouteParams& params, std::string_view& bad_param) const;
+
+    std::unique_ptr<Node> root_;
+};
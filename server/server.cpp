@@ -1,325 +1,366 @@
 #include "server.hpp"
 #include "../common/logger.hpp"
 #include "handlers.hpp"
+#include "catalog.hpp"
+#include "router.hpp"
+#include "response_cache.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
 #include <iostream>
-#include <sstream>
 #include <string>
 
-// === ThreadPool ===
-ThreadPool::ThreadPool(size_t threads) : stop(false) {
-    for (size_t i = 0; i < threads; ++i) {
-        workers.emplace_back([this] {
-            while (true) {
-                std::function<void()> task;
-                {
-                    std::unique_lock<std::mutex> lock(queue_mutex);
-                    condition.wait(lock, [this] { return stop || !tasks.empty(); });
-                    if (stop && tasks.empty()) return;
-                    task = std::move(tasks.front());
-                    tasks.pop();
-                }
-                task();
-            }
-        });
-    }
+namespace {
+
+// Обработчик маршрута, которому нужно тело запроса
+template<class F>
+RouteHandler with_body(std::string route, F handler) {
+    return [route = std::move(route), handler](const HttpRequest& request, const RouteParams& params) {
+        if (request.body.empty()) {
+            return HttpResponse::error(400, "No body in " + route);
+        }
+        return HttpResponse::ok(handler(request, params));
+    };
 }
 
+// Обработчик изменения каталога ждёт сохранения пачки в журнале
+// (Catalog::modify) и выполняется в пуле для блокирующих обработчиков
+constexpr bool WAITS_FOR_JOURNAL = true;
+
+// Обработчик маршрута без тела запроса
 template<class F>
-void ThreadPool::enqueue(F&& f) {
-    {
-        std::lock_guard<std::mutex> lock(queue_mutex);
-        tasks.emplace(std::forward<F>(f));
-    }
-    condition.notify_one();
+RouteHandler without_body(F handler) {
+    return [handler](const HttpRequest& request, const RouteParams& params) {
+        return HttpResponse::ok(handler(request, params));
+    };
 }
 
-ThreadPool::~ThreadPool() {
-    {
-        std::lock_guard<std::mutex> lock(queue_mutex);
-        stop = true;
-    }
-    condition.notify_all();
-    for (std::thread &worker : workers) {
-        if (worker.joinable()) worker.join();
-    }
+// GET-эндпоинт, ответ которого зависит только от набора данных dataset:
+// готовый ответ хранится до следующего изменения этого набора.
+// If-None-Match с актуальным ETag получает 304 без тела.
+template<class F>
+RouteHandler cached(Dataset dataset, F build) {
+    auto cache = std::make_shared<ResponseCache>();
+    return [cache, dataset, build](const HttpRequest& request, const RouteParams&) {
+        uint64_t version = Catalog::instance().snapshot()->version_of(dataset);
+        return HttpResponse::from(cache->respond(request, version, build));
+    };
 }
 
-template void ThreadPool::enqueue<std::function<void()>>(std::function<void()>&&);
+// Число строк запроса, для которых хранится готовый ответ
+constexpr size_t MAX_CACHED_QUERIES = 64;
 
-// === CarDeliveryServer ===
-CarDeliveryServer::CarDeliveryServer(unsigned short port)
-    : acceptor_(io_context_, boost::asio::ip::tcp::endpoint(boost::asio::ip::tcp::v4(), port)) {}
+// GET-эндпоинт, ответ которого зависит от набора данных dataset и строки
+// запроса (например, /cars?fields=...): свой кэш на каждую строку запроса.
+// Кэшей не больше MAX_CACHED_QUERIES, давно не запрашивавшиеся строки
+// вытесняются.
+template<class F>
+RouteHandler cached_by_query(Dataset dataset, F build) {
+    auto caches = std::make_shared<QueryResponseCache>(MAX_CACHED_QUERIES);
+    return [caches, dataset, build](const HttpRequest& request, const RouteParams&) {
+        uint64_t version = Catalog::instance().snapshot()->version_of(dataset);
+        auto build_body = [&] { return build(request.query); };
+        return HttpResponse::from(caches->get(request.query)->respond(request, version, build_body));
+    };
+}
 
-void CarDeliveryServer::run() {
-       Logger::log_info("Server started on port 8080");
-    std::cout << "Сервер запущен на порту 8080\n";
-    std::cout << "Ожидание подключений...\n";
+// GET-эндпоинт с неизменяемым ответом
+template<class F>
+RouteHandler cached(F build) {
+    auto cache = std::make_shared<ResponseCache>();
+    return [cache, build](const HttpRequest& request, const RouteParams&) {
+        return HttpResponse::from(cache->respond(request, 0, build));
+    };
+}
 
-    while (true) {
-        auto socket = std::make_shared<boost::asio::ip::tcp::socket>(io_context_);
-        acceptor_.accept(*socket);
-        client_pool_.enqueue([this, socket]() {
-            handle_client(socket);
-        });
-    }
+} // namespace
+
+// === ClientSession ===
+ClientSession::ClientSession(boost::asio::ip::tcp::socket socket, const Router& router,
+                             boost::asio::thread_pool& blocking_pool)
+    : socket_(std::move(socket)), timer_(socket_.get_executor()), buffer_(INITIAL_BUFFER_SIZE),
+      router_(router), blocking_pool_(blocking_pool) {}
+
+void ClientSession::start() {
+    boost::system::error_code ec;
+    auto remote_ep = socket_.remote_endpoint(ec);
+    client_ip_ = ec ? "unknown" : remote_ep.address().to_string();
+    std::cout << "[+] Новое подключение от " << client_ip_ << std::endl;
+    Logger::log_info("New connection from IP: " + client_ip_);
+
+    read_request();
 }
 
-void CarDeliveryServer::handle_client(std::shared_ptr<boost::asio::ip::tcp::socket> socket) {
-    try {
-        auto remote_ep = socket->remote_endpoint();
-        std::string client_ip = remote_ep.address().to_string();
-        std::cout << "[+] Новое подключение от " << client_ip << std::endl;
-        Logger::log_info("New connection from IP: " + client_ip);
-
-        // Читаем весь запрос
-        boost::asio::streambuf buffer;
-        boost::system::error_code ec;
-
-        // Читаем заголовки
-        boost::asio::read_until(*socket, buffer, "\r\n\r\n", ec);
-        if (ec && ec != boost::asio::error::eof) {
-            std::cerr << "Ошибка чтения заголовков: " << ec.message() << std::endl;
-              Logger::log_error("Error reading headers from " + client_ip + ": " + ec.message());
-            return;
+// Закрытие соединения, если ожидание what длится дольше timeout
+void ClientSession::start_timer(std::chrono::seconds timeout, const char* what) {
+    auto self = shared_from_this();
+    timer_.expires_after(timeout);
+    timer_.async_wait([this, self, what](const boost::system::error_code& ec) {
+        if (ec != boost::asio::error::operation_aborted) {
+            Logger::log_info(std::string(what) + " timeout for connection from " + client_ip_);
+            close();
         }
+    });
+}
 
-        std::string request{
-            std::istreambuf_iterator<char>(&buffer),
-            std::istreambuf_iterator<char>()
-        };
-
-        // Определяем длину тела для POST запросов
-        size_t content_length = 0;
-        size_t cl_pos = request.find("Content-Length: ");
-        if (cl_pos != std::string::npos) {
-            size_t end_line = request.find("\r\n", cl_pos);
-            std::string cl_str = request.substr(cl_pos + 16, end_line - cl_pos - 16);
-            try {
-                content_length = std::stoul(cl_str);
-            }
-            catch (const std::exception& e) {
-                std::cerr << "Ошибка парсинга Content-Length: " << e.what() << std::endl;
-                  Logger::log_error("Error parsing Content-Length from " + client_ip + ": " + std::string(e.what()));
-            }
+void ClientSession::read_request() {
+    // Конвейерный запрос мог уже оказаться в буфере — тогда он разбирается
+    // сразу, без обращения к сокету
+    switch (parser_.parse(buffer_.data(), buffer_size_)) {
+        case HttpParser::Result::Complete:
+            timer_.cancel();
+            request_started_ = false;
+            process_request();
+            return;
+        case HttpParser::Result::Error: {
+            std::cerr << "Ошибка разбора запроса: " << parser_.error() << std::endl;
+            Logger::log_error("Malformed request from " + client_ip_ + ": " + parser_.error());
+            keep_alive_ = false;
+            HttpResponse error = HttpResponse::error(parser_.error_status(), parser_.error());
+            response_ = PreparedResponse::make(error.status, error.body);
+            write_response();
+            return;
         }
+        case HttpParser::Result::Incomplete:
+            break;
+    }
+
+    if (buffer_size_ == buffer_.size()) {
+        buffer_.resize(buffer_.size() * 2);
+    }
+
+    // Срок начатого запроса ставится один раз и не продлевается каждым
+    // чтением, иначе клиент держал бы соединение, присылая по байту
+    if (buffer_size_ == 0) {
+        start_timer(IDLE_TIMEOUT, "Idle");
+    }
+    else if (!request_started_) {
+        request_started_ = true;
+        start_timer(REQUEST_TIMEOUT, "Request");
+    }
 
-        // Читаем тело если есть
-        if (content_length > 0) {
-            // Уже прочитали часть тела в буфер после заголовков
-            size_t body_start_pos = request.find("\r\n\r\n");
-            if (body_start_pos != std::string::npos) {
-                body_start_pos += 4;
-                size_t already_read = request.length() - body_start_pos;
-
-                // Добираем оставшиеся данные если нужно
-                if (already_read < content_length) {
-                    size_t remaining = content_length - already_read;
-                    std::vector<char> body_part(remaining);
-
-                    boost::asio::read(*socket, boost::asio::buffer(body_part), ec);
-                    if (!ec) {
-                        request += std::string(body_part.begin(), body_part.end());
-                    }
+    auto self = shared_from_this();
+    socket_.async_read_some(
+        boost::asio::buffer(buffer_.data() + buffer_size_, buffer_.size() - buffer_size_),
+        [this, self](const boost::system::error_code& ec, std::size_t bytes) {
+            if (ec) {
+                if (ec != boost::asio::error::eof && ec != boost::asio::error::operation_aborted) {
+                    std::cerr << "Ошибка чтения запроса: " << ec.message() << std::endl;
+                    Logger::log_error("Error reading request from " + client_ip_ + ": " + ec.message());
                 }
+                close();
+                return;
             }
-        }
+            buffer_size_ += bytes;
+            read_request();
+        });
+}
 
-        // Обработка запросов
-        std::string response_body;
+// Заголовок Connection для очередного ответа
+std::string ClientSession::connection_header() const {
+    if (!keep_alive_) {
+        return "Connection: close\r\n\r\n";
+    }
+    return "Connection: keep-alive\r\nKeep-Alive: timeout=" + std::to_string(IDLE_TIMEOUT.count()) +
+           ", max=" + std::to_string(MAX_REQUESTS_PER_CONNECTION - requests_served_) + "\r\n\r\n";
+}
 
-        // Отладочный вывод
-        std::cout << "=== НЕОБРАБОТАННЫЙ ЗАПРОС ===" << std::endl;
-        std::cout << request << std::endl;
-        std::cout << "=== ЗАВЕРШАЮЩИЙ ЗАПРОС ===" << std::endl;
+void ClientSession::process_request() {
+    const HttpRequest& request = parser_.request();
+    ++requests_served_;
+    keep_alive_ = request.keep_alive && requests_served_ < MAX_REQUESTS_PER_CONNECTION;
 
-        if (request.find("GET /cars") == 0) {
-                Logger::log_info("Processing GET /cars request from " + client_ip);
-            response_body = handle_get_cars();
-        }
-        else if (request.find("POST /search") == 0) {
-              Logger::log_info("Processing POST /search request from " + client_ip);
-            size_t body_start = request.find("\r\n\r\n");
-            if (body_start != std::string::npos) {
-                std::string body = request.substr(body_start + 4);
-                response_body = handle_post_search(body);
-            }
-            else {
-                response_body = R"({"error": "No body in POST /search"})";
-            }
-        }
-        else if (request.find("GET /search?") == 0) {
-            size_t s = request.find('?'), e = request.find(' ', s);
-            response_body = (s != std::string::npos && e != std::string::npos)
-                ? handle_get_search(request.substr(s + 1, e - s - 1))
-                : R"({"error": "Invalid query in GET /search"})";
-        }
-        else if (request.find("GET /cities") == 0) {
-            Logger::log_info("Processing GET /cities request from " + client_ip);
-            response_body = handle_get_cities();
-        }
-        else if (request.find("GET /documents") == 0) {
-            Logger::log_info("Processing GET /documents request from " + client_ip);
-            response_body = handle_get_documents();
-        }
-        else if (request.find("GET /delivery") == 0) {
-            Logger::log_info("Processing GET /delivery request from " + client_ip);
-            response_body = handle_get_delivery();
-        }
-        else if (request.find("POST /admin/login") == 0) {
-            Logger::log_info("Processing POST /admin/login request from " + client_ip);
-            size_t body_start = request.find("\r\n\r\n");
-            if (body_start != std::string::npos) {
-                std::string body = request.substr(body_start + 4);
-                response_body = handle_post_admin_login(body);
-            }
-            else {
-                response_body = R"({"error": "No body in POST /admin/login"})";
-            }
-        }
-        else if (request.find("POST /calculate-delivery") == 0) {
-            size_t body_start = request.find("\r\n\r\n");
-            if (body_start != std::string::npos) {
-                std::string body = request.substr(body_start + 4);
-                response_body = handle_post_calculate_delivery(body);
-            }
-            else {
-                response_body = R"({"error": "No body in POST /calculate-delivery"})";
-            }
-        }
- else if (request.find("POST /admin/cars") == 0) {
-            size_t body_start = request.find("\r\n\r\n");
-            if (body_start != std::string::npos) {
-                std::string body = request.substr(body_start + 4);
-                response_body = handle_post_admin_cars(body);
-            }
-            else {
-                response_body = R"({"error": "No body in POST /admin/cars"})";
-            }
-        }
-        else if (request.find("GET /admin/cars") == 0) {
-            response_body = handle_get_admin_cars();
-        }
-        else if (request.find("PUT /admin/cars/") == 0) {
-            // Извлекаем ID из URL: PUT /admin/cars/123
-            size_t start = request.find("/admin/cars/") + 12;  // длина "/admin/cars/"
-            size_t end = request.find(" ", start);
-            if (start < end && end != std::string::npos) {
-                std::string id_str = request.substr(start, end - start);
-                int car_id = std::stoi(id_str);
-
-                size_t body_start = request.find("\r\n\r\n");
-                if (body_start != std::string::npos) {
-                    std::string body = request.substr(body_start + 4);
-                    response_body = handle_put_admin_cars(car_id, body);
-                }
-                else {
-                    response_body = R"({"error": "No body in PUT /admin/cars/"})" + id_str + "\"}";
-                }
-            }
-            else {
-                response_body = R"({"error": "Invalid car ID in PUT /admin/cars"})";
-            }
-        }
-        else if (request.find("DELETE /admin/cars/") == 0) {
-            // Извлекаем ID из URL: DELETE /admin/cars/123
-            size_t start = request.find("/admin/cars/") + 12;  // длина "/admin/cars/"
-            size_t end = request.find(" ", start);
-            if (start < end && end != std::string::npos) {
-                std::string id_str = request.substr(start, end - start);
-                int car_id = std::stoi(id_str);
-                response_body = handle_delete_admin_cars(car_id);
-            }
-            else {
-                response_body = R"({"error": "Invalid car ID in DELETE /admin/cars"})";
-            }
-        }
-        else if (request.find("POST /admin/cities") == 0) {
-            size_t body_start = request.find("\r\n\r\n");
-            if (body_start != std::string::npos) {
-                std::string body = request.substr(body_start + 4);
-                response_body = handle_post_admin_cities(body);
-            }
-            else {
-                response_body = R"({"error": "No body in POST /admin/cities"})";
-            }
-        }
-        else if (request.find("GET /admin/cities") == 0) {
-            response_body = handle_get_admin_cities();
-        }
-        else if (request.find("PUT /admin/cities/") == 0) {
-            // Извлекаем ID из URL: PUT /admin/cities/123
-            size_t start = request.find("/admin/cities/") + 15;  // длина "/admin/cities/"
-            size_t end = request.find(" ", start);
-            if (start < end && end != std::string::npos) {
-                std::string id_str = request.substr(start, end - start);
-                int city_id = std::stoi(id_str);
-
-                size_t body_start = request.find("\r\n\r\n");
-                if (body_start != std::string::npos) {
-                    std::string body = request.substr(body_start + 4);
-                    response_body = handle_put_admin_cities(city_id, body);
-                }
-                else {
-                    response_body = R"({"error": "No body in PUT /admin/cities/"})" + id_str + "\"}";
-                }
-            }
-            else {
-                response_body = R"({"error": "Invalid city ID in PUT /admin/cities"})";
-            }
-        }
-        else if (request.find("DELETE /admin/cities/") == 0) {
-            // Извлекаем ID из URL: DELETE /admin/cities/123
-            size_t start = request.find("/admin/cities/") + 15;  // длина "/admin/cities/"
-            size_t end = request.find(" ", start);
-            if (start < end && end != std::string::npos) {
-                std::string id_str = request.substr(start, end - start);
-                int city_id = std::stoi(id_str);
-                response_body = handle_delete_admin_cities(city_id);
-            }
-            else {
-                response_body = R"({"error": "Invalid city ID in DELETE /admin/cities"})";
-            }
-        }
-        else if (request.find("POST /admin/documents") == 0) {
-            size_t body_start = request.find("\r\n\r\n");
-            if (body_start != std::string::npos) {
-                std::string body = request.substr(body_start + 4);
-                response_body = handle_post_admin_documents(body);
-            }
-            else {
-                response_body = R"({"error": "No body in POST /admin/documents"})";
-            }
-        }
-        else if (request.find("GET /admin/documents") == 0) {
-            response_body = handle_get_admin_documents();
-        }
-        else if (request.find("DELETE /admin/documents") == 0) {
-            size_t body_start = request.find("\r\n\r\n");
-            if (body_start != std::string::npos) {
-                std::string body = request.substr(body_start + 4);
-                response_body = handle_delete_admin_documents(body);
+    if (router_.blocking(request)) {
+        // Пока обработчик ждёт в пуле, сессия не читает сокет и не трогает
+        // буфер с запросом; ответ отправляется снова в strand сессии
+        auto self = shared_from_this();
+        boost::asio::post(blocking_pool_, [this, self] {
+            auto response = respond();
+            boost::asio::post(socket_.get_executor(), [this, self, response = std::move(response)]() mutable {
+                send(std::move(response));
+            });
+        });
+        return;
+    }
+    send(respond());
+}
+
+std::shared_ptr<const PreparedResponse> ClientSession::respond() {
+    const HttpRequest& request = parser_.request();
+    try {
+        Logger::log_info("Processing " + std::string(request.method) + " " + std::string(request.path) +
+                         " request from " + client_ip_);
+        HttpResponse response = router_.dispatch(request);
+        return response.prepared ? std::move(response.prepared)
+                                 : PreparedResponse::make(response.status, response.body);
+    }
+    catch (std::exception& e) {
+        std::cerr << "[!] Ошибка обработки клиента " << e.what() << std::endl;
+        Logger::log_error("Client processing error: " + std::string(e.what()));
+        return nullptr;
+    }
+}
+
+void ClientSession::send(std::shared_ptr<const PreparedResponse> response) {
+    if (!response) {
+        close();
+        return;
+    }
+    response_ = std::move(response);
+    write_response();
+}
+
+void ClientSession::write_response() {
+    // Заголовки, Connection и тело уходят одной записью без склейки в одну строку
+    connection_header_ = connection_header();
+    std::array<boost::asio::const_buffer, 3> buffers = {
+        boost::asio::buffer(response_->head()),
+        boost::asio::buffer(connection_header_),
+        boost::asio::buffer(response_->body())
+    };
+
+    auto self = shared_from_this();
+    start_timer(WRITE_TIMEOUT, "Write");
+    boost::asio::async_write(socket_, buffers,
+        [this, self](const boost::system::error_code& ec, std::size_t) {
+            timer_.cancel();
+            if (ec) {
+                std::cerr << "[!] Ошибка отправки ответа " << ec.message() << std::endl;
+                Logger::log_error("Error writing response to " + client_ip_ + ": " + ec.message());
+                close();
+                return;
             }
-            else {
-                response_body = R"({"error": "No body in DELETE /admin/documents"})";
+
+            std::cout << "[✓] Запрос от " << client_ip_ << " обработан\n";
+            Logger::log_info("Request from " + client_ip_ + " processed successfully");
+            if (!keep_alive_) {
+                close();
+                return;
             }
-        }
 
+            // Сдвигаем в начало буфера непрочитанный остаток (конвейерные запросы)
+            size_t consumed = parser_.consumed();
+            std::memmove(buffer_.data(), buffer_.data() + consumed, buffer_size_ - consumed);
+            buffer_size_ -= consumed;
+            parser_.reset();
+            read_request(); // следующий запрос по тому же соединению
+        });
+}
+
+void ClientSession::close() {
+    boost::system::error_code ignored;
+    timer_.cancel();
+    socket_.shutdown(boost::asio::ip::tcp::socket::shutdown_both, ignored);
+    socket_.close(ignored);
+}
+
+// === CarDeliveryServer ===
+CarDeliveryServer::CarDeliveryServer(unsigned short port, size_t threads)
+    : acceptor_(io_context_, boost::asio::ip::tcp::endpoint(boost::asio::ip::tcp::v4(), port)),
+      accept_timer_(io_context_),
+      thread_count_(std::max<size_t>(threads, 1)), blocking_pool_(BLOCKING_THREADS) {
+    // Каталог загружается один раз и дальше обслуживается из памяти
+    Catalog::instance().load("data");
+    watcher_ = std::make_unique<DataWatcher>("data");
+    register_routes();
+}
+
+// Таблица маршрутов строится один раз при старте
+void CarDeliveryServer::register_routes() {
+    // Эндпоинты клиентской части
+    router_.add("GET", "/cars", cached_by_query(Dataset::Cars, [](std::string_view query) {
+        return handle_get_cars(query);
+    }));
+    router_.add("GET", "/cars/facets", cached_by_query(Dataset::Cars, [](std::string_view query) {
+        return handle_get_car_facets(query);
+    }));
+    // Подсказки не кэшируются: строк запроса почти столько же, сколько нажатий
+    // клавиш, а ответ по индексу строится быстро
+    router_.add("GET", "/cars/suggest", without_body([](const HttpRequest& request, const RouteParams&) {
+        return handle_get_car_suggest(request.query);
+    }));
+    router_.add("POST", "/cars/facets", with_body("POST /cars/facets", [](const HttpRequest& request, const RouteParams&) {
+        return handle_post_car_facets(request.body);
+    }));
+    router_.add("POST", "/search", with_body("POST /search", [](const HttpRequest& request, const RouteParams&) {
+        return handle_post_search(request.body);
+    }));
+    router_.add("GET", "/search", without_body([](const HttpRequest& request, const RouteParams&) {
+        return handle_get_search(request.query);
+    }));
+    router_.add("GET", "/cities", cached(Dataset::Cities, &handle_get_cities));
+    router_.add("GET", "/documents", cached(Dataset::Documents, &handle_get_documents));
+    router_.add("GET", "/delivery", cached(&handle_get_delivery));
+    router_.add("POST", "/calculate-delivery", with_body("POST /calculate-delivery", [](const HttpRequest& request, const RouteParams&) {
+        return handle_post_calculate_delivery(request.body);
+    }));
+
+    // Эндпоинты админки
+    router_.add("POST", "/admin/login", with_body("POST /admin/login", [](const HttpRequest& request, const RouteParams&) {
+        return handle_post_admin_login(request.body);
+    }));
+    router_.add("GET", "/admin/cars", cached(Dataset::Cars, &handle_get_admin_cars));
+    router_.add("POST", "/admin/cars", with_body("POST /admin/cars", [](const HttpRequest& request, const RouteParams&) {
+        return handle_post_admin_cars(request.body);
+    }), WAITS_FOR_JOURNAL);
+    router_.add("POST", "/admin/cars/bulk", with_body("POST /admin/cars/bulk", [](const HttpRequest& request, const RouteParams&) {
+        return handle_post_admin_cars_bulk(request.body);
+    }), WAITS_FOR_JOURNAL);
+    router_.add("PUT", "/admin/cars/{id:int}", with_body("PUT /admin/cars", [](const HttpRequest& request, const RouteParams& params) {
+        return handle_put_admin_cars(params.get_int("id"), request.body);
+    }), WAITS_FOR_JOURNAL);
+    router_.add("DELETE", "/admin/cars/{id:int}", without_body([](const HttpRequest&, const RouteParams& params) {
+        return handle_delete_admin_cars(params.get_int("id"));
+    }), WAITS_FOR_JOURNAL);
+    router_.add("GET", "/admin/cities", cached(Dataset::Cities, &handle_get_admin_cities));
+    router_.add("POST", "/admin/cities", with_body("POST /admin/cities", [](const HttpRequest& request, const RouteParams&) {
+        return handle_post_admin_cities(request.body);
+    }), WAITS_FOR_JOURNAL);
+    router_.add("PUT", "/admin/cities/{id:int}", with_body("PUT /admin/cities", [](const HttpRequest& request, const RouteParams& params) {
+        return handle_put_admin_cities(params.get_int("id"), request.body);
+    }), WAITS_FOR_JOURNAL);
+    router_.add("DELETE", "/admin/cities/{id:int}", without_body([](const HttpRequest&, const RouteParams& params) {
+        return handle_delete_admin_cities(params.get_int("id"));
+    }), WAITS_FOR_JOURNAL);
+    router_.add("GET", "/admin/documents", cached(Dataset::Documents, &handle_get_admin_documents));
+    router_.add("POST", "/admin/documents", with_body("POST /admin/documents", [](const HttpRequest& request, const RouteParams&) {
+        return handle_post_admin_documents(request.body);
+    }), WAITS_FOR_JOURNAL);
+    router_.add("DELETE", "/admin/documents", with_body("DELETE /admin/documents", [](const HttpRequest& request, const RouteParams&) {
+        return handle_delete_admin_documents(request.body);
+    }), WAITS_FOR_JOURNAL);
+}
 
-        // Отправка ответа
-        std::ostringstream resp;
-        resp << "HTTP/1.1 200 OK\r\n"
-            << "Content-Type: application/json\r\n"
-            << "Content-Length: " << response_body.size() << "\r\n"
-            << "Connection: close\r\n\r\n"
-            << response_body;
+void CarDeliveryServer::run() {
+    Logger::log_info("Server started on port 8080 with " + std::to_string(thread_count_) + " I/O threads");
+    std::cout << "Сервер запущен на порту 8080\n";
+    std::cout << "Ожидание подключений...\n";
 
-        boost::asio::write(*socket, boost::asio::buffer(resp.str()));
-        std::cout << "[✓] Запрос от " << client_ip << " обработан\n";
-            Logger::log_info("Request from " + client_ip + " processed successfully");
+    do_accept();
 
+    // io_context_ обслуживается пулом потоков, текущий поток — один из них
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < thread_count_; ++i) {
+        workers.emplace_back([this] { io_context_.run(); });
     }
-    catch (std::exception& e) {
-        std::cerr << "[!] Ошибка обработки клиента " << e.what() << std::endl;
-         Logger::log_error("Client processing error: " + std::string(e.what()));
+    io_context_.run();
+    for (std::thread& worker : workers) {
+        if (worker.joinable()) worker.join();
     }
 }
+
+void CarDeliveryServer::do_accept() {
+    // Каждое соединение получает собственный strand
+    acceptor_.async_accept(boost::asio::make_strand(io_context_),
+        [this](const boost::system::error_code& ec, boost::asio::ip::tcp::socket socket) {
+            if (!ec) {
+                std::make_shared<ClientSession>(std::move(socket), router_, blocking_pool_)->start();
+                do_accept();
+                return;
+            }
+            std::cerr << "[!] Ошибка приёма подключения " << ec.message() << std::endl;
+            Logger::log_error("Accept error: " + ec.message());
+            accept_timer_.expires_after(ACCEPT_RETRY_DELAY);
+            accept_timer_.async_wait([this](const boost::system::error_code&) { do_accept(); });
+        });
+}
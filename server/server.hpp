@@ -1,36 +1,84 @@
 #pragma once
+#include "http_parser.hpp"
+#include "data_watcher.hpp"
+#include "router.hpp"
 #include <boost/asio.hpp>
+#include <chrono>
 #include <thread>
 #include <vector>
-#include <queue>
-#include <mutex>
-#include <condition_variable>
-#include <functional>
 #include <memory>
+#include <string>
+#include <string_view>
 
-class ThreadPool {
+// Соединение с клиентом: асинхронное чтение запросов и запись ответов.
+// Все операции сессии выполняются последовательно в её strand, поэтому
+// медленный клиент не занимает поток, пока ждёт данных.
+// Соединение постоянное (HTTP/1.1 keep-alive): запросы обрабатываются по
+// очереди, конвейерные запросы из буфера — в порядке поступления.
+class ClientSession : public std::enable_shared_from_this<ClientSession> {
 public:
-    explicit ThreadPool(size_t threads);
-    template<class F> void enqueue(F&& f);
-    ~ThreadPool();
+    // Время ожидания следующего запроса и лимит запросов на соединение
+    static constexpr std::chrono::seconds IDLE_TIMEOUT{15};
+    // Начатый запрос должен прийти целиком, а ответ — уйти за это время,
+    // сколько бы раз клиент ни присылал или ни забирал по байту
+    static constexpr std::chrono::seconds REQUEST_TIMEOUT{30};
+    static constexpr std::chrono::seconds WRITE_TIMEOUT{30};
+    static constexpr size_t MAX_REQUESTS_PER_CONNECTION = 100;
+    static constexpr size_t INITIAL_BUFFER_SIZE = 8 * 1024;
+
+    ClientSession(boost::asio::ip::tcp::socket socket, const Router& router,
+                  boost::asio::thread_pool& blocking_pool);
+    void start();
 
 private:
-    std::vector<std::thread> workers;
-    std::queue<std::function<void()>> tasks;
-    std::mutex queue_mutex;
-    std::condition_variable condition;
-    bool stop = false;
+    void read_request();
+    void process_request();
+    // Ответ обработчика маршрута; nullptr — ошибка, соединение закрывается
+    std::shared_ptr<const PreparedResponse> respond();
+    void send(std::shared_ptr<const PreparedResponse> response);
+    void write_response();
+    std::string connection_header() const;
+    void start_timer(std::chrono::seconds timeout, const char* what);
+    void close();
+
+    boost::asio::ip::tcp::socket socket_;
+    boost::asio::steady_timer timer_;
+    std::vector<char> buffer_; // буфер чтения, запросы разбираются прямо в нём
+    size_t buffer_size_ = 0;
+    HttpParser parser_;
+    const Router& router_;
+    boost::asio::thread_pool& blocking_pool_; // для маршрутов с blocking = true
+    std::string client_ip_;
+    std::shared_ptr<const PreparedResponse> response_;
+    std::string connection_header_;
+    size_t requests_served_ = 0;
+    bool keep_alive_ = false;
+    bool request_started_ = false; // срок REQUEST_TIMEOUT уже отсчитывается
 };
 
 class CarDeliveryServer {
 public:
-    explicit CarDeliveryServer(unsigned short port = 8080);
+    // Потоки для блокирующих обработчиков (изменения каталога ждут fsync
+    // журнала). Потоки ввода-вывода при этом не ждут, а число одновременно
+    // ждущих изменений — предел размера пачки group commit в Catalog.
+    static constexpr size_t BLOCKING_THREADS = 64;
+    // Пауза перед новым accept после ошибки (например, EMFILE), чтобы не
+    // крутиться в цикле, пока дескрипторы не освободятся
+    static constexpr std::chrono::milliseconds ACCEPT_RETRY_DELAY{100};
+
+    explicit CarDeliveryServer(unsigned short port = 8080,
+                               size_t threads = std::thread::hardware_concurrency());
     void run();
 
 private:
-    void handle_client(std::shared_ptr<boost::asio::ip::tcp::socket> socket);
+    void register_routes();
+    void do_accept();
 
+    Router router_;
     boost::asio::io_context io_context_;
     boost::asio::ip::tcp::acceptor acceptor_;
-    ThreadPool client_pool_{6}; // 6 потоков для всех запросов
-};
\ No newline at end of file
+    boost::asio::steady_timer accept_timer_;
+    size_t thread_count_; // потоки, выполняющие io_context_.run()
+    boost::asio::thread_pool blocking_pool_;
+    std::unique_ptr<DataWatcher> watcher_; // перезагрузка data/*.json после правки
+};
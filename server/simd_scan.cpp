@@ -0,0 +1,240 @@
+#include "simd_scan.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SIMD_SCAN_X86 1
+#endif
+
+namespace {
+
+// === Скалярная реализация (и обработка хвоста для векторных) ===
+
+template<class T>
+void range_scalar(const T* values, size_t begin, size_t n, T lo, T hi, uint64_t* bits) {
+    for (size_t w = begin / 64; w * 64 < n; ++w) {
+        uint64_t word = 0;
+        size_t end = w * 64 + 64 < n ? w * 64 + 64 : n;
+        for (size_t i = w * 64; i < end; ++i) {
+            word |= static_cast<uint64_t>(values[i] >= lo && values[i] <= hi) << (i - w * 64);
+        }
+        bits[w] = word;
+    }
+}
+
+void present_scalar(const uint8_t* present, size_t begin, size_t n, uint64_t* bits) {
+    for (size_t w = begin / 64; w * 64 < n; ++w) {
+        uint64_t word = 0;
+        size_t end = w * 64 + 64 < n ? w * 64 + 64 : n;
+        for (size_t i = w * 64; i < end; ++i) {
+            word |= static_cast<uint64_t>(present[i] != 0) << (i - w * 64);
+        }
+        bits[w] &= word;
+    }
+}
+
+void range_i32_scalar(const int32_t* values, size_t n, int32_t lo, int32_t hi, uint64_t* bits) {
+    range_scalar(values, 0, n, lo, hi, bits);
+}
+void range_u32_scalar(const uint32_t* values, size_t n, uint32_t lo, uint32_t hi, uint64_t* bits) {
+    range_scalar(values, 0, n, lo, hi, bits);
+}
+void range_f64_scalar(const double* values, size_t n, double lo, double hi, uint64_t* bits) {
+    range_scalar(values, 0, n, lo, hi, bits);
+}
+void present_and_scalar(const uint8_t* present, size_t n, uint64_t* bits) {
+    present_scalar(present, 0, n, bits);
+}
+
+#ifdef SIMD_SCAN_X86
+
+// === AVX2: 8 значений int32/uint32 или 4 double за инструкцию ===
+// Проверка lo <= v <= hi через max/min без переполнения на границах типа:
+// max(v, lo) == v и min(v, hi) == v.
+
+__attribute__((target("avx2")))
+void range_i32_avx2(const int32_t* values, size_t n, int32_t lo, int32_t hi, uint64_t* bits) {
+    const __m256i vlo = _mm256_set1_epi32(lo);
+    const __m256i vhi = _mm256_set1_epi32(hi);
+    size_t full = n / 64;
+    for (size_t w = 0; w < full; ++w) {
+        uint64_t word = 0;
+        for (size_t k = 0; k < 8; ++k) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + w * 64 + k * 8));
+            __m256i in = _mm256_and_si256(_mm256_cmpeq_epi32(_mm256_max_epi32(v, vlo), v),
+                                          _mm256_cmpeq_epi32(_mm256_min_epi32(v, vhi), v));
+            word |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(in)))) << (k * 8);
+        }
+        bits[w] = word;
+    }
+    range_scalar(values, full * 64, n, lo, hi, bits);
+}
+
+__attribute__((target("avx2")))
+void range_u32_avx2(const uint32_t* values, size_t n, uint32_t lo, uint32_t hi, uint64_t* bits) {
+    const __m256i vlo = _mm256_set1_epi32(static_cast<int32_t>(lo));
+    const __m256i vhi = _mm256_set1_epi32(static_cast<int32_t>(hi));
+    size_t full = n / 64;
+    for (size_t w = 0; w < full; ++w) {
+        uint64_t word = 0;
+        for (size_t k = 0; k < 8; ++k) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + w * 64 + k * 8));
+            __m256i in = _mm256_and_si256(_mm256_cmpeq_epi32(_mm256_max_epu32(v, vlo), v),
+                                          _mm256_cmpeq_epi32(_mm256_min_epu32(v, vhi), v));
+            word |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(in)))) << (k * 8);
+        }
+        bits[w] = word;
+    }
+    range_scalar(values, full * 64, n, lo, hi, bits);
+}
+
+__attribute__((target("avx2")))
+void range_f64_avx2(const double* values, size_t n, double lo, double hi, uint64_t* bits) {
+    const __m256d vlo = _mm256_set1_pd(lo);
+    const __m256d vhi = _mm256_set1_pd(hi);
+    size_t full = n / 64;
+    for (size_t w = 0; w < full; ++w) {
+        uint64_t word = 0;
+        for (size_t k = 0; k < 16; ++k) {
+            __m256d v = _mm256_loadu_pd(values + w * 64 + k * 4);
+            __m256d in = _mm256_and_pd(_mm256_cmp_pd(v, vlo, _CMP_GE_OQ), _mm256_cmp_pd(v, vhi, _CMP_LE_OQ));
+            word |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_pd(in))) << (k * 4);
+        }
+        bits[w] = word;
+    }
+    range_scalar(values, full * 64, n, lo, hi, bits);
+}
+
+__attribute__((target("avx2")))
+void present_and_avx2(const uint8_t* present, size_t n, uint64_t* bits) {
+    const __m256i zero = _mm256_setzero_si256();
+    size_t full = n / 64;
+    for (size_t w = 0; w < full; ++w) {
+        __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(present + w * 64));
+        __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(present + w * 64 + 32));
+        uint64_t absent = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(low, zero))) |
+                          static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(high, zero)))) << 32;
+        bits[w] &= ~absent;
+    }
+    present_scalar(present, full * 64, n, bits);
+}
+
+// === SSE4.1: 4 значения int32/uint32 или 2 double за инструкцию ===
+
+__attribute__((target("sse4.1")))
+void range_i32_sse41(const int32_t* values, size_t n, int32_t lo, int32_t hi, uint64_t* bits) {
+    const __m128i vlo = _mm_set1_epi32(lo);
+    const __m128i vhi = _mm_set1_epi32(hi);
+    size_t full = n / 64;
+    for (size_t w = 0; w < full; ++w) {
+        uint64_t word = 0;
+        for (size_t k = 0; k < 16; ++k) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + w * 64 + k * 4));
+            __m128i in = _mm_and_si128(_mm_cmpeq_epi32(_mm_max_epi32(v, vlo), v),
+                                       _mm_cmpeq_epi32(_mm_min_epi32(v, vhi), v));
+            word |= static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(in)))) << (k * 4);
+        }
+        bits[w] = word;
+    }
+    range_scalar(values, full * 64, n, lo, hi, bits);
+}
+
+__attribute__((target("sse4.1")))
+void range_u32_sse41(const uint32_t* values, size_t n, uint32_t lo, uint32_t hi, uint64_t* bits) {
+    const __m128i vlo = _mm_set1_epi32(static_cast<int32_t>(lo));
+    const __m128i vhi = _mm_set1_epi32(static_cast<int32_t>(hi));
+    size_t full = n / 64;
+    for (size_t w = 0; w < full; ++w) {
+        uint64_t word = 0;
+        for (size_t k = 0; k < 16; ++k) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + w * 64 + k * 4));
+            __m128i in = _mm_and_si128(_mm_cmpeq_epi32(_mm_max_epu32(v, vlo), v),
+                                       _mm_cmpeq_epi32(_mm_min_epu32(v, vhi), v));
+            word |= static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(in)))) << (k * 4);
+        }
+        bits[w] = word;
+    }
+    range_scalar(values, full * 64, n, lo, hi, bits);
+}
+
+__attribute__((target("sse4.1")))
+void range_f64_sse41(const double* values, size_t n, double lo, double hi, uint64_t* bits) {
+    const __m128d vlo = _mm_set1_pd(lo);
+    const __m128d vhi = _mm_set1_pd(hi);
+    size_t full = n / 64;
+    for (size_t w = 0; w < full; ++w) {
+        uint64_t word = 0;
+        for (size_t k = 0; k < 32; ++k) {
+            __m128d v = _mm_loadu_pd(values + w * 64 + k * 2);
+            __m128d in = _mm_and_pd(_mm_cmpge_pd(v, vlo), _mm_cmple_pd(v, vhi));
+            word |= static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_pd(in))) << (k * 2);
+        }
+        bits[w] = word;
+    }
+    range_scalar(values, full * 64, n, lo, hi, bits);
+}
+
+__attribute__((target("sse4.1")))
+void present_and_sse41(const uint8_t* present, size_t n, uint64_t* bits) {
+    const __m128i zero = _mm_setzero_si128();
+    size_t full = n / 64;
+    for (size_t w = 0; w < full; ++w) {
+        uint64_t absent = 0;
+        for (size_t k = 0; k < 4; ++k) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(present + w * 64 + k * 16));
+            absent |= static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, zero)))) << (k * 16);
+        }
+        bits[w] &= ~absent;
+    }
+    present_scalar(present, full * 64, n, bits);
+}
+
+#endif // SIMD_SCAN_X86
+
+// Таблица ядер выбранной реализации
+struct Kernels {
+    const char* name;
+    void (*range_i32)(const int32_t*, size_t, int32_t, int32_t, uint64_t*);
+    void (*range_u32)(const uint32_t*, size_t, uint32_t, uint32_t, uint64_t*);
+    void (*range_f64)(const double*, size_t, double, double, uint64_t*);
+    void (*present_and)(const uint8_t*, size_t, uint64_t*);
+};
+
+Kernels select_kernels() {
+#ifdef SIMD_SCAN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return {"avx2", range_i32_avx2, range_u32_avx2, range_f64_avx2, present_and_avx2};
+    }
+    if (__builtin_cpu_supports("sse4.1")) {
+        return {"sse4.1", range_i32_sse41, range_u32_sse41, range_f64_sse41, present_and_sse41};
+    }
+#endif
+    return {"scalar", range_i32_scalar, range_u32_scalar, range_f64_scalar, present_and_scalar};
+}
+
+const Kernels& kernels() {
+    static const Kernels selected = select_kernels();
+    return selected;
+}
+
+} // namespace
+
+void scan_range(const int32_t* values, size_t n, int32_t lo, int32_t hi, uint64_t* bits) {
+    kernels().range_i32(values, n, lo, hi, bits);
+}
+
+void scan_range(const uint32_t* values, size_t n, uint32_t lo, uint32_t hi, uint64_t* bits) {
+    kernels().range_u32(values, n, lo, hi, bits);
+}
+
+void scan_range(const double* values, size_t n, double lo, double hi, uint64_t* bits) {
+    kernels().range_f64(values, n, lo, hi, bits);
+}
+
+void scan_and_present(const uint8_t* present, size_t n, uint64_t* bits) {
+    kernels().present_and(present, n, bits);
+}
+
+const char* scan_implementation() {
+    return kernels().name;
+}
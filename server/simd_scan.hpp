@@ -0,0 +1,20 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Векторные ядра условий по числовым столбцам. Каждое ядро записывает в bits
+// по одному биту на строку (ceil(n / 64) слов, старшие биты последнего слова
+// обнуляются). Реализация (AVX2, SSE4.1 или скалярная) выбирается один раз
+// по возможностям процессора, поэтому сервер собирается без -mavx2 и
+// работает на любом x86-64.
+
+// lo <= values[i] <= hi
+void scan_range(const int32_t* values, size_t n, int32_t lo, int32_t hi, uint64_t* bits);
+void scan_range(const uint32_t* values, size_t n, uint32_t lo, uint32_t hi, uint64_t* bits);
+void scan_range(const double* values, size_t n, double lo, double hi, uint64_t* bits);
+
+// bits[i] &= present[i] != 0
+void scan_and_present(const uint8_t* present, size_t n, uint64_t* bits);
+
+// Имя выбранной реализации: "avx2", "sse4.1" или "scalar"
+const char* scan_implementation();
@@ -0,0 +1,223 @@
+#include "text_index.hpp"
+#include <algorithm>
+#include <numeric>
+#include <tuple>
+
+namespace {
+
+// Символы UTF-8 строки; неверный байт считается отдельным символом
+std::u32string decode_utf8(std::string_view text) {
+    std::u32string result;
+    result.reserve(text.size());
+    for (size_t i = 0; i < text.size();) {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        size_t length = c < 0x80 ? 1 : (c >> 5) == 0x6 ? 2 : (c >> 4) == 0xE ? 3 : (c >> 3) == 0x1E ? 4 : 0;
+        if (length == 0 || i + length > text.size()) {
+            result += c;
+            ++i;
+            continue;
+        }
+        char32_t cp = length == 1 ? c : c & (0x7F >> length);
+        for (size_t k = 1; k < length; ++k) {
+            cp = (cp << 6) | (static_cast<unsigned char>(text[i + k]) & 0x3F);
+        }
+        result += cp;
+        i += length;
+    }
+    return result;
+}
+
+void encode_utf8(char32_t cp, std::string& out) {
+    if (cp < 0x80) {
+        out += static_cast<char>(cp);
+    }
+    else if (cp < 0x800) {
+        out += static_cast<char>(0xC0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+    else if (cp < 0x10000) {
+        out += static_cast<char>(0xE0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+    else {
+        out += static_cast<char>(0xF0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+
+char32_t fold_char(char32_t cp) {
+    if (cp >= U'A' && cp <= U'Z') return cp + 0x20;
+    if (cp >= 0xC0 && cp <= 0xDE && cp != 0xD7) return cp + 0x20; // À-Þ
+    if (cp >= 0x410 && cp <= 0x42F) return cp + 0x20;              // А-Я
+    if (cp >= 0x400 && cp <= 0x40F) return cp + 0x50;              // Ѐ-Џ (Ё и др.)
+    return cp;
+}
+
+// Триграммы ключа с двумя символами-заполнителями в начале: по одной на символ,
+// поэтому у префикса длины m ровно m триграмм, и каждая правка портит не больше
+// трёх (перестановка соседних символов — четырёх)
+std::vector<uint64_t> trigrams(const std::u32string& text) {
+    std::vector<uint64_t> grams;
+    grams.reserve(text.size());
+    char32_t a = 0, b = 0;
+    for (char32_t c : text) {
+        grams.push_back((static_cast<uint64_t>(a) << 42) | (static_cast<uint64_t>(b) << 21) | c);
+        a = b;
+        b = c;
+    }
+    std::sort(grams.begin(), grams.end());
+    grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+    return grams;
+}
+
+// Наименьшее расстояние между query и началом key: вставки, удаления, замены
+// и перестановки соседних символов ("hodna" — "honda" за одну правку);
+// больше max_distance — значит, не подходит (счёт обрывается)
+int prefix_distance(const std::u32string& query, const std::u32string& key, int max_distance) {
+    const size_t m = query.size();
+    std::vector<int> before(m + 1), column(m + 1), next(m + 1);
+    std::iota(column.begin(), column.end(), 0);
+    int best = column[m];
+
+    for (size_t j = 0; j < key.size() && j < m + static_cast<size_t>(max_distance); ++j) {
+        next[0] = static_cast<int>(j + 1);
+        int column_min = next[0];
+        for (size_t i = 1; i <= m; ++i) {
+            next[i] = std::min({column[i] + 1, next[i - 1] + 1, column[i - 1] + (query[i - 1] != key[j])});
+            if (i > 1 && j > 0 && query[i - 1] == key[j - 1] && query[i - 2] == key[j]) {
+                next[i] = std::min(next[i], before[i - 2] + 1);
+            }
+            column_min = std::min(column_min, next[i]);
+        }
+        std::swap(before, column);
+        std::swap(column, next);
+        best = std::min(best, column[m]);
+        // Минимум столбца не убывает: дальше расстояние только больше
+        if (column_min > max_distance) break;
+    }
+    return best;
+}
+
+} // namespace
+
+std::string fold_case(std::string_view value) {
+    std::string folded;
+    folded.reserve(value.size());
+    // Быстрый путь для ASCII
+    if (std::all_of(value.begin(), value.end(), [](char c) { return static_cast<unsigned char>(c) < 0x80; })) {
+        for (char c : value) folded += c >= 'A' && c <= 'Z' ? static_cast<char>(c + 0x20) : c;
+        return folded;
+    }
+    for (char32_t cp : decode_utf8(value)) encode_utf8(fold_char(cp), folded);
+    return folded;
+}
+
+void TextIndex::add(uint32_t id, std::string_view value) {
+    std::string folded = fold_case(value);
+    exact_[folded].push_back(id);
+
+    // Ключи: всё значение и его окончания с начала каждого следующего слова
+    insert_key(folded, id);
+    for (size_t i = 1; i < folded.size(); ++i) {
+        bool separator = folded[i - 1] == ' ' || folded[i - 1] == '-';
+        if (separator && folded[i] != ' ' && folded[i] != '-') {
+            insert_key(std::string_view(folded).substr(i), id);
+        }
+    }
+}
+
+void TextIndex::insert_key(std::string_view folded, uint32_t id) {
+    uint32_t node = 0;
+    for (char c : folded) {
+        auto& children = nodes_[node].children;
+        auto it = std::lower_bound(children.begin(), children.end(), c,
+            [](const std::pair<char, uint32_t>& child, char byte) { return child.first < byte; });
+        if (it != children.end() && it->first == c) {
+            node = it->second;
+            continue;
+        }
+        uint32_t child = static_cast<uint32_t>(nodes_.size());
+        children.insert(it, {c, child});
+        nodes_.emplace_back();
+        node = child;
+    }
+    nodes_[node].ids.push_back(id);
+
+    uint32_t key = static_cast<uint32_t>(keys_.size());
+    keys_.push_back({decode_utf8(folded), id});
+    for (uint64_t gram : trigrams(keys_.back().text)) {
+        trigrams_[gram].push_back(key);
+    }
+}
+
+std::vector<uint32_t> TextIndex::exact(std::string_view folded) const {
+    auto it = exact_.find(std::string(folded));
+    return it == exact_.end() ? std::vector<uint32_t>() : it->second;
+}
+
+std::vector<uint32_t> TextIndex::with_prefix(std::string_view folded_prefix) const {
+    uint32_t node = 0;
+    for (char c : folded_prefix) {
+        const auto& children = nodes_[node].children;
+        auto it = std::lower_bound(children.begin(), children.end(), c,
+            [](const std::pair<char, uint32_t>& child, char byte) { return child.first < byte; });
+        if (it == children.end() || it->first != c) return {};
+        node = it->second;
+    }
+
+    // Все ключи поддерева
+    std::vector<uint32_t> ids;
+    std::vector<uint32_t> stack = {node};
+    while (!stack.empty()) {
+        const Node& current = nodes_[stack.back()];
+        stack.pop_back();
+        ids.insert(ids.end(), current.ids.begin(), current.ids.end());
+        for (const auto& child : current.children) stack.push_back(child.second);
+    }
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    return ids;
+}
+
+std::vector<std::pair<uint32_t, int>> TextIndex::fuzzy_prefix(std::string_view folded_query, int max_distance) const {
+    std::u32string query = decode_utf8(folded_query);
+    if (query.empty()) return {};
+
+    // Кандидаты: ключи, у которых уцелело достаточно триграмм запроса.
+    // Для короткого запроса порог не отсекает ничего — проверяются все ключи.
+    std::vector<uint32_t> candidates;
+    std::vector<uint64_t> grams = trigrams(query);
+    int needed = static_cast<int>(grams.size()) - 4 * max_distance;
+    if (needed <= 0) {
+        candidates.resize(keys_.size());
+        std::iota(candidates.begin(), candidates.end(), 0);
+    }
+    else {
+        std::unordered_map<uint32_t, int> shared;
+        for (uint64_t gram : grams) {
+            auto it = trigrams_.find(gram);
+            if (it == trigrams_.end()) continue;
+            for (uint32_t key : it->second) ++shared[key];
+        }
+        for (const auto& [key, count] : shared) {
+            if (count >= needed) candidates.push_back(key);
+        }
+    }
+
+    std::unordered_map<uint32_t, int> best;
+    for (uint32_t key : candidates) {
+        int distance = prefix_distance(query, keys_[key].text, max_distance);
+        if (distance > max_distance) continue;
+        auto [it, inserted] = best.emplace(keys_[key].id, distance);
+        if (!inserted) it->second = std::min(it->second, distance);
+    }
+
+    std::vector<std::pair<uint32_t, int>> result(best.begin(), best.end());
+    std::sort(result.begin(), result.end(), [](const auto& a, const auto& b) {
+        return std::tie(a.second, a.first) < std::tie(b.second, b.first);
+    });
+    return result;
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Приведение UTF-8 строки к нижнему регистру для сравнения без учёта
+// регистра: латиница, Latin-1 (À-Þ) и кириллица (А-Я, Ѐ-Џ)
+std::string fold_case(std::string_view value);
+
+// Индекс значений строкового столбца для подсказок и поиска без учёта
+// регистра. Значения приводятся fold_case и хранятся в префиксном дереве по
+// байтам UTF-8 — целиком и с начала каждого слова, чтобы "cru" находило
+// "Land Cruiser", — и в триграммном индексе по символам для поиска с
+// опечатками. Значения только добавляются, как и в словарь столбца, номера
+// которого хранит индекс.
+class TextIndex {
+public:
+    // Новое значение словаря с номером id
+    void add(uint32_t id, std::string_view value);
+
+    // Номера значений, совпадающих с folded без учёта регистра
+    std::vector<uint32_t> exact(std::string_view folded) const;
+    // Номера значений, у которых целиком или с начала слова идёт prefix
+    std::vector<uint32_t> with_prefix(std::string_view folded_prefix) const;
+    // Номера значений, начало которых (целиком или с начала слова) отличается
+    // от query не более чем на max_distance правок (расстояние Левенштейна по
+    // символам с перестановкой соседних), и наименьшее расстояние; кандидаты
+    // отбираются по триграммам
+    std::vector<std::pair<uint32_t, int>> fuzzy_prefix(std::string_view folded_query, int max_distance) const;
+
+    size_t size() const { return exact_.size(); }
+
+private:
+    struct Node {
+        std::vector<std::pair<char, uint32_t>> children; // по возрастанию байта
+        std::vector<uint32_t> ids;                       // ключи, которые здесь заканчиваются
+    };
+
+    // Ключ поиска: значение или его часть с начала слова, по символам
+    struct Key {
+        std::u32string text;
+        uint32_t id;
+    };
+
+    void insert_key(std::string_view folded, uint32_t id);
+
+    std::vector<Node> nodes_ = std::vector<Node>(1); // nodes_[0] — корень
+    std::vector<Key> keys_;
+    std::unordered_map<uint64_t, std::vector<uint32_t>> trigrams_; // триграмма -> номера ключей
+    std::unordered_map<std::string, std::vector<uint32_t>> exact_;
+};
@@ -0,0 +1,139 @@
+#include "wal.hpp"
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <unistd.h>
+
+namespace {
+
+bool write_all(int fd, const std::string& data) {
+    size_t written = 0;
+    while (written < data.size()) {
+        ssize_t n = ::write(fd, data.data() + written, data.size() - written);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        written += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// fsync каталога, в котором лежит path: иначе создание или переименование
+// файла может не пережить падение машины
+void sync_directory(const std::string& path) {
+    size_t slash = path.rfind('/');
+    std::string dir = slash == std::string::npos ? "." : path.substr(0, slash);
+    int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) return;
+    ::fsync(fd);
+    ::close(fd);
+}
+
+// Записи из содержимого журнала и длина его целой части: разбор
+// останавливается на первой неполной или испорченной строке
+std::vector<json> parse_entries(const std::string& content, size_t& valid_length) {
+    std::vector<json> entries;
+    valid_length = 0;
+    size_t start = 0;
+    size_t end;
+    // Строка без '\n' в конце файла — недописанная запись
+    while ((end = content.find('\n', start)) != std::string::npos) {
+        try {
+            entries.push_back(json::parse(content.begin() + static_cast<std::ptrdiff_t>(start),
+                                          content.begin() + static_cast<std::ptrdiff_t>(end)));
+        }
+        catch (const json::exception&) {
+            break;
+        }
+        start = end + 1;
+        valid_length = start;
+    }
+    return entries;
+}
+
+std::string read_content(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+} // namespace
+
+WriteAheadLog::WriteAheadLog(std::string path) : path_(std::move(path)) {
+    fd_ = ::open(path_.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        throw std::runtime_error("Failed to open " + path_ + ": " + std::strerror(errno));
+    }
+    // Хвост, оборванный падением, отрезается: иначе новые записи оказались
+    // бы за ним, и чтение остановилось бы раньше них
+    size_t valid_length;
+    std::string content = read_content(path_);
+    parse_entries(content, valid_length);
+    if (valid_length < content.size() &&
+        (::ftruncate(fd_, static_cast<off_t>(valid_length)) != 0 || ::fsync(fd_) != 0)) {
+        ::close(fd_);
+        throw std::runtime_error("Failed to truncate torn tail of " + path_ + ": " + std::strerror(errno));
+    }
+    sync_directory(path_);
+}
+
+WriteAheadLog::~WriteAheadLog() {
+    if (fd_ >= 0) ::close(fd_);
+}
+
+void WriteAheadLog::append(const std::vector<json>& entries) {
+    if (entries.empty()) return;
+    std::string lines;
+    for (const auto& entry : entries) {
+        lines += entry.dump();
+        lines += '\n';
+    }
+    if (poisoned_) {
+        throw std::runtime_error("Journal " + path_ + " is unusable until the next checkpoint");
+    }
+    off_t offset = ::lseek(fd_, 0, SEEK_END);
+    if (offset < 0) {
+        throw std::runtime_error("Failed to seek " + path_ + ": " + std::strerror(errno));
+    }
+    if (!write_all(fd_, lines) || ::fdatasync(fd_) != 0) {
+        int error = errno;
+        // Отклонённая пачка не должна остаться в журнале ни целиком (её
+        // применили бы при загрузке), ни оборванной строкой (чтение
+        // остановилось бы на ней и потеряло следующие пачки)
+        if (::ftruncate(fd_, offset) != 0 || ::fdatasync(fd_) != 0) poisoned_ = true;
+        throw std::runtime_error("Failed to write " + path_ + ": " + std::strerror(error));
+    }
+    size_ += entries.size();
+}
+
+void WriteAheadLog::reset() {
+    if (::ftruncate(fd_, 0) != 0 || ::fsync(fd_) != 0) {
+        throw std::runtime_error("Failed to truncate " + path_ + ": " + std::strerror(errno));
+    }
+    size_ = 0;
+    poisoned_ = false;
+}
+
+std::vector<json> WriteAheadLog::read(const std::string& path) {
+    size_t valid_length;
+    return parse_entries(read_content(path), valid_length);
+}
+
+bool write_file_atomically(const std::string& path, const std::string& content) {
+    std::string tmp_path = path + ".tmp";
+    int fd = ::open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+    bool ok = write_all(fd, content) && ::fsync(fd) == 0;
+    ok = ::close(fd) == 0 && ok;
+    if (!ok || std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+        std::remove(tmp_path.c_str());
+        return false;
+    }
+    sync_directory(path);
+    return true;
+}
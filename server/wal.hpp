@@ -0,0 +1,46 @@
+#pragma once
+#include "../common/json.hpp"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+using json = nlohmann::json;
+
+// Журнал изменений (write-ahead log) в формате JSON lines: по одной записи
+// на строку, только дописывание в конец файла. append() возвращается после
+// fsync, поэтому записанное переживает падение процесса и машины. Пачка
+// записей пишется одним write и одним fsync; при ошибке файл обрезается
+// до начала пачки. При открытии отрезается оборванный падением хвост.
+class WriteAheadLog {
+public:
+    explicit WriteAheadLog(std::string path);
+    ~WriteAheadLog();
+    WriteAheadLog(const WriteAheadLog&) = delete;
+    WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+
+    // Записи по порядку; ошибка записи — std::runtime_error, и пачки в
+    // журнале нет. Если файл не удалось обрезать обратно, журнал отказывает
+    // в записи до следующей очистки (reset)
+    void append(const std::vector<json>& entries);
+    // Очистка журнала после контрольной точки
+    void reset();
+    bool poisoned() const { return poisoned_; }
+
+    // Число записей, дописанных с открытия или последней очистки
+    size_t size() const { return size_; }
+    const std::string& path() const { return path_; }
+
+    // Записи журнала по порядку. Чтение останавливается на первой неполной
+    // или испорченной строке — это хвост, который не успел записаться.
+    static std::vector<json> read(const std::string& path);
+
+private:
+    std::string path_;
+    int fd_ = -1;
+    size_t size_ = 0;
+    bool poisoned_ = false; // обрыв пачки не удалось отрезать
+};
+
+// Атомарная замена файла: запись во временный файл рядом, fsync и rename,
+// затем fsync каталога. false, если что-то не удалось (старый файл цел).
+bool write_file_atomically(const std::string& path, const std::string& content);
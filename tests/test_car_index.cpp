@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+#include "../server/car_store.hpp"
+
+class CarIndexTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        cars = json::parse(R"([
+            {"id": 1, "brand": "Toyota", "model": "Camry", "country": "Japan", "year": 2020, "price_usd": 25000},
+            {"id": 2, "brand": "BMW", "model": "X5", "country": "Germany", "year": 2016, "price_usd": 17000},
+            {"id": 3, "brand": "Toyota", "model": "Prius", "country": "Japan", "year": 2018, "price_usd": 12000},
+            {"id": 4, "brand": "Honda", "model": "Fit", "country": "Japan", "year": "2019", "price_usd": 7000}
+        ])");
+        store = CarStore::from_json(cars);
+    }
+
+    // Позиции автомобилей со строковым значением поля
+    CarIndex::Postings find(std::string_view field, std::string_view value) const {
+        int column = CarStore::string_column(field);
+        return store.index().find(column, store.dictionary(column).find(value)).to_vector();
+    }
+
+    CarIndex::Postings find_range(std::string_view field, double min, double max) const {
+        return store.index().find_range(CarStore::numeric_column(field), min, max);
+    }
+
+    json cars;
+    CarStore store;
+};
+
+TEST_F(CarIndexTest, FindsPostingsInRowOrder) {
+    EXPECT_EQ(find("brand", "Toyota"), (CarIndex::Postings{0, 2}));
+    EXPECT_TRUE(find("brand", "Lada").empty());
+}
+
+TEST_F(CarIndexTest, IntersectsPostings) {
+    const CarIndex& index = store.index();
+    int country = CarStore::string_column("country");
+    int brand = CarStore::string_column("brand");
+    const RoaringBitmap& japan = index.find(country, store.dictionary(country).find("Japan"));
+    const RoaringBitmap& toyota = index.find(brand, store.dictionary(brand).find("Toyota"));
+    EXPECT_EQ((japan & toyota).to_vector(), (CarIndex::Postings{0, 2}));
+    EXPECT_EQ(RoaringBitmap::and_cardinality(japan, toyota), 2u);
+}
+
+TEST_F(CarIndexTest, RemoveShiftsLaterRows) {
+    store.remove(1);
+    EXPECT_TRUE(find("brand", "BMW").empty());
+    EXPECT_EQ(find("brand", "Toyota"), (CarIndex::Postings{0, 1}));
+    EXPECT_EQ(find("brand", "Honda"), (CarIndex::Postings{2}));
+    EXPECT_EQ(store.index().size(), 3u);
+}
+
+TEST_F(CarIndexTest, UpdateAndAppend) {
+    json updated = cars[0];
+    updated["brand"] = "Lexus";
+    store.update(0, updated);
+    EXPECT_EQ(find("brand", "Toyota"), (CarIndex::Postings{2}));
+    EXPECT_EQ(find("brand", "Lexus"), (CarIndex::Postings{0}));
+
+    store.append(json{{"id", 5}, {"brand", "Lexus"}});
+    EXPECT_EQ(find("brand", "Lexus"), (CarIndex::Postings{0, 4}));
+}
+
+TEST_F(CarIndexTest, FindsRangeIncludingUntypedValues) {
+    // "2019" — строка, поэтому возвращается всегда и проверяется вызывающим
+    EXPECT_EQ(find_range("year", 2018, 2020), (CarIndex::Postings{0, 2, 3}));
+    EXPECT_EQ(store.index().estimate_range(CarStore::Year, 2018, 2020), 3u);
+    EXPECT_EQ(find_range("price_usd", 10000, 20000), (CarIndex::Postings{1, 2}));
+    EXPECT_TRUE(find_range("price_usd", 30000, 20000).empty());
+}
+
+TEST_F(CarIndexTest, RangeFollowsUpdatesAndRemovals) {
+    json updated = cars[1];
+    updated["price_usd"] = 9000;
+    store.update(1, updated);
+    EXPECT_EQ(find_range("price_usd", 0, 10000), (CarIndex::Postings{1, 3}));
+
+    store.remove(0);
+    EXPECT_EQ(find_range("price_usd", 0, 10000), (CarIndex::Postings{0, 2}));
+    EXPECT_EQ(find_range("price_usd", 12000, 12000), (CarIndex::Postings{1}));
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,393 @@
+#include <gtest/gtest.h>
+#include "../server/car_store.hpp"
+#include "../server/car_filter.hpp"
+#include "../server/car_page.hpp"
+#include "../server/car_facets.hpp"
+#include "../server/car_snapshot.hpp"
+#include <algorithm>
+#include <cstdio>
+
+TEST(CarStoreTest, RoundTripsJson) {
+    json cars = json::parse(R"([
+        {"id": 1, "brand": "Toyota", "year": 2020, "engine_volume": 2.5, "price_usd": 25000, "color": "red"},
+        {"id": 2, "brand": "BMW", "year": "2016", "engine_volume": 2, "price_usd": -5},
+        {"id": 3, "model": "Fit", "horsepower": 98.5}
+    ])");
+    CarStore store = CarStore::from_json(cars);
+    EXPECT_EQ(store.size(), 3u);
+    EXPECT_EQ(store.to_json(), cars);
+    EXPECT_EQ(store.to_json().dump(), cars.dump());
+}
+
+TEST(CarStoreTest, KeepsUnexpectedTypesAsIs) {
+    CarStore store = CarStore::from_json(json::parse(R"([{"id": 1, "year": "2019", "price_usd": 1.5}])"));
+    double value;
+    EXPECT_FALSE(store.numeric(CarStore::Year, 0, value));
+    ASSERT_NE(store.extra(0, "year"), nullptr);
+    EXPECT_EQ(*store.extra(0, "year"), "2019");
+    EXPECT_EQ(store.to_json(0)["price_usd"], 1.5);
+}
+
+TEST(CarStoreTest, FindsById) {
+    CarStore store = CarStore::from_json(json::parse(R"([{"id": 7}, {"id": 3}, {"brand": "X"}])"));
+    EXPECT_EQ(store.find_id(3), 1u);
+    EXPECT_FALSE(store.find_id(5).has_value());
+    EXPECT_EQ(store.allocate_id(), 8);
+
+    // Позиции за удалённой строкой сдвигаются, а id не переиспользуются
+    store.remove(0);
+    EXPECT_EQ(store.find_id(3), 0u);
+    EXPECT_FALSE(store.find_id(7).has_value());
+    store.update(0, json{{"id", 12}});
+    EXPECT_EQ(store.find_id(12), 0u);
+    EXPECT_FALSE(store.find_id(3).has_value());
+    EXPECT_EQ(store.allocate_id(), 13);
+}
+
+TEST(CarStoreTest, BulkUpdateRebuildsIndexOnce) {
+    CarStore store = CarStore::from_json(json::parse(R"([
+        {"id": 1, "brand": "Toyota", "year": 2020},
+        {"id": 2, "brand": "BMW", "year": 2016}
+    ])"));
+    {
+        CarStore::BulkUpdate bulk(store);
+        store.append(json{{"id", 3}, {"brand", "Tesla"}, {"year", 2022}});
+        store.update(*store.find_id(1), json{{"id", 1}, {"brand", "Lexus"}, {"year", 2021}});
+        store.remove(*store.find_id(2));
+        store.append(json{{"id", 4}, {"brand", "Tesla"}, {"year", 2018}});
+        EXPECT_EQ(store.find_id(4), 2u); // id доступны внутри пачки
+    }
+
+    // После пачки индексы совпадают с построенными заново
+    CarStore rebuilt = CarStore::from_json(store.to_json());
+    for (const char* brand : {"Toyota", "BMW", "Lexus", "Tesla"}) {
+        json filters = {{"brand", brand}};
+        EXPECT_EQ(CarFilter(store, filters).search(), CarFilter(rebuilt, filters).search()) << brand;
+    }
+    json range = {{"year", {{"$gte", 2019}}}};
+    EXPECT_EQ(CarFilter(store, range).search(), (std::vector<uint32_t>{0, 1}));
+    EXPECT_EQ(store.index().text(0).with_prefix("tes").size(), 1u);
+}
+
+TEST(CarSnapshotTest, RoundTripsStoreAndIndexes) {
+    CarStore store = CarStore::from_json(json::parse(R"([
+        {"id": 1, "brand": "Toyota", "model": "Land Cruiser", "year": 2020, "price_usd": 25000, "engine_volume": 2.5},
+        {"id": 9, "brand": "BMW", "year": "2016", "horsepower": 184, "tags": ["a"]},
+        {"brand": "Toyota", "color": null},
+        "not an object"
+    ])"));
+    store.remove(*store.find_id(9));
+    store.append(json{{"id", 5}, {"brand", "Лада"}, {"price_usd", 9000}});
+
+    CarStore copy = CarSnapshot::decode(CarSnapshot::encode(store));
+    EXPECT_EQ(copy.to_json(), store.to_json());
+    EXPECT_EQ(copy.find_id(5), 3u);
+    // Счётчик id сохраняется: удалённый id 9 не выдаётся снова
+    EXPECT_EQ(copy.allocate_id(), 10);
+
+    json filters = {{"brand", "Toyota"}, {"price_usd", {{"$gte", 20000}}}};
+    EXPECT_EQ(CarFilter(copy, filters).search(), (std::vector<uint32_t>{0}));
+    EXPECT_EQ(copy.index().text(0).exact(fold_case("ЛАДА")).size(), 1u);
+}
+
+TEST(CarSnapshotTest, RejectsDamagedData) {
+    CarStore store = CarStore::from_json(json::parse(R"([{"id": 1, "brand": "Toyota", "year": 2020}])"));
+    std::string data = CarSnapshot::encode(store);
+
+    std::string flipped = data;
+    flipped[flipped.size() - 3] ^= 0x40;
+    EXPECT_THROW(CarSnapshot::decode(flipped), std::runtime_error);
+    EXPECT_THROW(CarSnapshot::decode(data.substr(0, data.size() - 8)), std::runtime_error);
+    EXPECT_THROW(CarSnapshot::decode(data.substr(0, 10)), std::runtime_error);
+
+    std::string other_version = data;
+    other_version[8] = 2;
+    EXPECT_THROW(CarSnapshot::decode(other_version), std::runtime_error);
+    EXPECT_THROW(CarSnapshot::decode(std::string(64, 'x')), std::runtime_error);
+}
+
+TEST(CarSnapshotTest, ReadsMissingAndWrittenFiles) {
+    const std::string path = "test_cars.snapshot";
+    std::remove(path.c_str());
+    EXPECT_FALSE(CarSnapshot::read(path).has_value());
+
+    CarStore store = CarStore::from_json(json::parse(R"([{"id": 3, "model": "Camry"}])"));
+    ASSERT_TRUE(CarSnapshot::write(store, path));
+    auto loaded = CarSnapshot::read(path);
+    ASSERT_TRUE(loaded.has_value());
+    EXPECT_EQ(loaded->to_json(), store.to_json());
+    std::remove(path.c_str());
+}
+
+TEST(CarSnapshotTest, ServesColumnsFromMappedFileUntilChanged) {
+    const std::string path = "test_cars_mapped.snapshot";
+    CarStore source = CarStore::from_json(json::parse(R"([
+        {"id": 1, "brand": "Toyota", "year": 2020, "price_usd": 25000},
+        {"id": 2, "brand": "BMW", "year": 2016, "price_usd": 18000}
+    ])"));
+    ASSERT_TRUE(CarSnapshot::write(source, path));
+    auto loaded = CarSnapshot::read(path);
+    std::remove(path.c_str()); // отображение остаётся верным и без имени файла
+    ASSERT_TRUE(loaded.has_value());
+    const CarStore& mapped = *loaded;
+    EXPECT_TRUE(mapped.years().values.mapped());
+    EXPECT_TRUE(mapped.string_values(0).present.mapped());
+    EXPECT_EQ(CarFilter(mapped, {{"year", {{"$gte", 2018}}}}).search(), (std::vector<uint32_t>{0}));
+
+    // Изменение копии переносит в её память только затронутое, оригинал не меняется
+    CarStore copy = mapped;
+    copy.update(1, json{{"id", 2}, {"brand", "BMW"}, {"year", 2021}, {"price_usd", 18000}});
+    EXPECT_FALSE(copy.years().values.mapped());
+    EXPECT_TRUE(mapped.years().values.mapped());
+    EXPECT_EQ(mapped.years().values[1], 2016);
+    EXPECT_EQ(CarFilter(copy, {{"year", {{"$gte", 2018}}}}).search(), (std::vector<uint32_t>{0, 1}));
+    EXPECT_EQ(mapped.to_json(), source.to_json());
+}
+
+TEST(CarStoreTest, WritesProjectedFieldsLikeDump) {
+    json cars = json::parse(R"([
+        {"id": 1, "brand": "Toy\"ota\n", "year": 2020, "engine_volume": 2.0, "price_usd": 25000, "color": "red"},
+        {"id": 2, "brand": "BMW", "year": "2016", "engine_volume": 1.5, "horsepower": 300},
+        {"model": "Fit", "horsepower": 98.5, "tags": [1, 2]}
+    ])");
+    CarStore store = CarStore::from_json(cars);
+    std::vector<std::string> fields = {"year", "id", "brand", "engine_volume", "color", "horsepower", "tags", "id"};
+    CarStore::Projection projection(fields);
+
+    for (uint32_t row = 0; row < store.size(); ++row) {
+        json expected = json::object();
+        for (const auto& field : fields) {
+            if (cars[row].contains(field)) expected[field] = cars[row][field];
+        }
+        std::string out;
+        store.write_json(row, projection, out);
+        EXPECT_EQ(out, expected.dump()) << row;
+    }
+}
+
+TEST(CarFilterTest, MatchesJsonSemantics) {
+    CarStore store = CarStore::from_json(json::parse(R"([
+        {"id": 1, "brand": "Toyota", "year": 2020, "engine_volume": 2.0},
+        {"id": 2, "brand": "Toyota", "year": "2019", "engine_volume": 1.5},
+        {"id": 3, "brand": "Honda", "year": 2017, "color": "red"}
+    ])"));
+
+    auto search = [&](const char* filters) {
+        return CarFilter(store, json::parse(filters)).search();
+    };
+    EXPECT_EQ(search(R"({"brand": "Toyota"})"), (std::vector<uint32_t>{0, 1}));
+    EXPECT_EQ(search(R"({"year": {"$gte": 2018}})"), (std::vector<uint32_t>{0, 1})); // "2019" > число по типу
+    EXPECT_EQ(search(R"({"year": {"$lte": 2018}})"), (std::vector<uint32_t>{2}));
+    EXPECT_EQ(search(R"({"engine_volume": 2})"), (std::vector<uint32_t>{0}));
+    EXPECT_EQ(search(R"({"color": "red"})"), (std::vector<uint32_t>{2}));
+    EXPECT_EQ(search(R"({"brand": "Lada"})"), (std::vector<uint32_t>{}));
+    EXPECT_EQ(search(R"({})"), (std::vector<uint32_t>{0, 1, 2}));
+}
+
+TEST(CarFilterTest, ColumnScanAgreesWithRowChecks) {
+    // Широкие условия выбирают большую часть каталога и идут через просмотр столбцов
+    json cars = json::array();
+    for (int i = 0; i < 500; ++i) {
+        json car = {{"id", i + 1}, {"brand", i % 3 ? "Toyota" : "BMW"}, {"price_usd", 1000 + i * 10}};
+        if (i % 7 == 0) car["year"] = "2019";
+        else if (i % 11) car["year"] = 2000 + i % 25;
+        if (i % 5 == 0) car["engine_volume"] = 1.5 + (i % 4) * 0.5;
+        cars.push_back(car);
+    }
+    CarStore store = CarStore::from_json(cars);
+
+    for (const char* text : {R"({"brand": "Toyota", "year": {"$gte": 2005}})",
+                             R"({"price_usd": {"$lte": 5000}, "engine_volume": {"$gte": 2.0}})",
+                             R"({"year": {"$gte": 2000, "$lte": 2030}})"}) {
+        json filters = json::parse(text);
+        CarFilter filter(store, filters);
+        std::vector<uint32_t> expected;
+        for (uint32_t row = 0; row < store.size(); ++row) {
+            if (filter.matches(row)) expected.push_back(row);
+        }
+        EXPECT_EQ(filter.search(), expected) << text;
+    }
+}
+
+TEST(CarFilterTest, CountsStringFiltersFromPostings) {
+    CarStore store = CarStore::from_json(json::parse(R"([
+        {"brand": "Toyota", "country": "Japan", "fuel_type": "hybrid"},
+        {"brand": "Toyota", "country": "Japan", "fuel_type": "petrol"},
+        {"brand": "Honda", "country": "Japan", "fuel_type": "hybrid"},
+        {"brand": "Toyota", "country": "USA", "fuel_type": "hybrid"}
+    ])"));
+    auto count = [&](const char* filters) { return CarFilter(store, json::parse(filters)).count(); };
+    EXPECT_EQ(count(R"({"brand": "Toyota"})"), 3u);
+    EXPECT_EQ(count(R"({"brand": "Toyota", "country": "Japan"})"), 2u);
+    EXPECT_EQ(count(R"({"brand": "Toyota", "country": "Japan", "fuel_type": "hybrid"})"), 1u);
+    EXPECT_EQ(count(R"({"brand": "Lada", "country": "Japan"})"), 0u);
+    EXPECT_EQ(count(R"({})"), 4u);
+    EXPECT_EQ(CarFilter(store, json::parse(R"({"brand": "Toyota", "fuel_type": "hybrid"})")).search(),
+              (std::vector<uint32_t>{0, 3}));
+}
+
+TEST(CarFilterTest, CompilesComparisonOperators) {
+    json cars = json::array();
+    for (int i = 0; i < 300; ++i) {
+        json car = {{"id", i + 1}, {"brand", i % 4 == 0 ? "BMW" : i % 4 == 1 ? "Audi" : "Toyota"},
+                    {"year", 2000 + i % 20}, {"price_usd", 5000 + i * 100}};
+        if (i % 9 == 0) car["year"] = "2015";
+        if (i % 6 == 0) car["engine_volume"] = 1.0 + (i % 5) * 0.5;
+        cars.push_back(car);
+    }
+    CarStore store = CarStore::from_json(cars);
+
+    // Результат поиска по индексам и столбцам совпадает с построчной проверкой
+    auto linear = [&](const CarFilter& filter) {
+        std::vector<uint32_t> rows;
+        for (uint32_t row = 0; row < store.size(); ++row) {
+            if (filter.matches(row)) rows.push_back(row);
+        }
+        return rows;
+    };
+    for (const char* text : {R"({"year": {"$gt": 2010, "$lt": 2013}})",
+                             R"({"year": {"$between": [2005, 2006]}, "brand": {"$ne": "BMW"}})",
+                             R"({"brand": {"$in": ["BMW", "Audi", "Lada"]}})",
+                             R"({"brand": {"$in": ["BMW", "Audi"]}, "price_usd": {"$gte": 30000}})",
+                             R"({"price_usd": {"$in": [5000, 5100, 9900]}})",
+                             R"({"engine_volume": {"$gt": 1.5}, "year": {"$ne": 2001}})",
+                             R"({"price_usd": {"$gt": 5000.5, "$lte": 5300}})",
+                             R"({"year": {"$eq": "2015"}})"}) {
+        CarFilter filter(store, json::parse(text));
+        EXPECT_EQ(filter.search(), linear(filter)) << text;
+        EXPECT_EQ(filter.count(), linear(filter).size()) << text;
+    }
+
+    auto search = [&](const char* filters) { return CarFilter(store, json::parse(filters)).search(); };
+    EXPECT_EQ(search(R"({"price_usd": {"$gt": 5000, "$lt": 5300}})"), (std::vector<uint32_t>{1, 2}));
+    EXPECT_EQ(search(R"({"price_usd": {"$between": [5000, 5100]}})"), (std::vector<uint32_t>{0, 1}));
+    EXPECT_EQ(search(R"({"price_usd": {"$in": [5100, 5300]}})"), (std::vector<uint32_t>{1, 3}));
+    EXPECT_EQ(search(R"({"brand": {"$in": ["Audi"]}, "price_usd": {"$lte": 6000}})"), (std::vector<uint32_t>{1, 5, 9}));
+    EXPECT_EQ(search(R"({"price_usd": {"$lte": 5200}, "brand": {"$ne": "BMW"}})"), (std::vector<uint32_t>{1, 2}));
+    EXPECT_EQ(search(R"({"brand": {"$in": []}})"), (std::vector<uint32_t>{}));
+}
+
+TEST(CarFilterTest, RejectsUnknownOperators) {
+    CarStore store = CarStore::from_json(json::parse(R"([{"id": 1, "year": 2020}])"));
+    EXPECT_THROW(CarFilter(store, json::parse(R"({"year": {"$gtee": 2019}})")), std::invalid_argument);
+    EXPECT_THROW(CarFilter(store, json::parse(R"({"year": {"$in": 2019}})")), std::invalid_argument);
+    EXPECT_THROW(CarFilter(store, json::parse(R"({"year": {"$between": [2019]}})")), std::invalid_argument);
+    EXPECT_EQ(CarFilter(store, json::parse(R"({"year": {"$eq": 2020}})")).search(), (std::vector<uint32_t>{0}));
+}
+
+TEST(CarPageTest, TopKMatchesFullSort) {
+    json cars = json::array();
+    for (int i = 0; i < 200; ++i) {
+        json car = {{"id", i + 1}};
+        if (i % 10) car["price_usd"] = (i * 37) % 50 * 100; // повторяющиеся цены
+        cars.push_back(car);
+    }
+    CarStore store = CarStore::from_json(cars);
+    std::vector<uint32_t> rows(store.size());
+    for (uint32_t row = 0; row < rows.size(); ++row) rows[row] = row;
+
+    for (bool descending : {false, true}) {
+        // Полная сортировка: цена (без цены — в конце), затем позиция
+        std::vector<uint32_t> expected = rows;
+        std::stable_sort(expected.begin(), expected.end(), [&](uint32_t a, uint32_t b) {
+            auto ka = sort_key(store, CarStore::PriceUsd, a);
+            auto kb = sort_key(store, CarStore::PriceUsd, b);
+            if (ka.has_value() != kb.has_value()) return ka.has_value();
+            return ka && *ka != *kb && (descending ? *ka > *kb : *ka < *kb);
+        });
+
+        PageRequest request;
+        request.sort_column = CarStore::PriceUsd;
+        request.descending = descending;
+        request.offset = 15;
+        request.limit = 20;
+        Page page = select_page(store, rows, request);
+        EXPECT_EQ(page.rows, std::vector<uint32_t>(expected.begin() + 15, expected.begin() + 35));
+        EXPECT_TRUE(page.more);
+
+        // Проход курсором собирает ту же последовательность целиком
+        std::vector<uint32_t> collected;
+        request.offset = 0;
+        request.after_row.reset();
+        request.after_key.reset();
+        for (bool more = true; more;) {
+            page = select_page(store, rows, request);
+            collected.insert(collected.end(), page.rows.begin(), page.rows.end());
+            more = page.more;
+            request.after_row = page.rows.back();
+            request.after_key = sort_key(store, CarStore::PriceUsd, page.rows.back());
+        }
+        EXPECT_EQ(collected, expected);
+    }
+}
+
+TEST(CarPageTest, CatalogOrderSlices) {
+    CarStore store = CarStore::from_json(json::parse(R"([{"id": 1}, {"id": 2}, {"id": 3}, {"id": 4}])"));
+    std::vector<uint32_t> rows = {0, 2, 3};
+    PageRequest request;
+    request.limit = 2;
+    Page page = select_page(store, rows, request);
+    EXPECT_EQ(page.rows, (std::vector<uint32_t>{0, 2}));
+    EXPECT_TRUE(page.more);
+    request.after_row = 2u;
+    page = select_page(store, rows, request);
+    EXPECT_EQ(page.rows, (std::vector<uint32_t>{3}));
+    EXPECT_FALSE(page.more);
+}
+
+TEST(CarFacetsTest, CountsValuesAndBuckets) {
+    CarStore store = CarStore::from_json(json::parse(R"([
+        {"brand": "Toyota", "year": 2019, "price_usd": 12000, "engine_volume": 1.6},
+        {"brand": "Toyota", "year": 2020, "price_usd": 24999, "engine_volume": 2.0},
+        {"brand": "BMW", "year": "2018", "price_usd": 26000},
+        {"brand": "Honda", "year": 2020, "price_usd": 9000, "engine_volume": 1.5}
+    ])"));
+
+    json all = car_facets(store, nullptr);
+    EXPECT_EQ(all["found"], 4);
+    EXPECT_EQ(all["values"]["brand"], json::parse(R"({"Toyota": 2, "BMW": 1, "Honda": 1})"));
+    EXPECT_EQ(all["values"]["country"], json::object());
+    EXPECT_EQ(all["histograms"]["price_usd"]["buckets"],
+              json::parse(R"([{"from": 5000, "count": 1}, {"from": 10000, "count": 1},
+                              {"from": 20000, "count": 1}, {"from": 25000, "count": 1}])"));
+    EXPECT_EQ(all["histograms"]["price_usd"]["min"], 9000);
+    EXPECT_EQ(all["histograms"]["price_usd"]["max"], 26000);
+    // "2018" хранится нетипизированным и в гистограмму не входит
+    EXPECT_EQ(all["histograms"]["year"]["buckets"],
+              json::parse(R"([{"from": 2019, "count": 1}, {"from": 2020, "count": 2}])"));
+    EXPECT_EQ(all["histograms"]["engine_volume"]["buckets"],
+              json::parse(R"([{"from": 1.5, "count": 2}, {"from": 2.0, "count": 1}])"));
+    EXPECT_FALSE(all["histograms"].contains("horsepower"));
+
+    // По выбранным строкам результат совпадает с фасетами подмножества
+    std::vector<uint32_t> rows = {0, 1, 3};
+    json some = car_facets(store, &rows);
+    EXPECT_EQ(some["found"], 3);
+    EXPECT_EQ(some["values"]["brand"], json::parse(R"({"Toyota": 2, "Honda": 1})"));
+    EXPECT_EQ(some["histograms"]["price_usd"]["max"], 24999);
+}
+
+TEST(CarFacetsTest, WidensBucketsForExtremeValues) {
+    CarStore store = CarStore::from_json(json::parse(R"([
+        {"brand": "Toyota", "year": -2000000000, "horsepower": 100, "engine_volume": -1e300},
+        {"brand": "Toyota", "year": 2000000000, "horsepower": 2000000000, "engine_volume": 1e300},
+        {"brand": "BMW", "year": 2020, "horsepower": 150, "engine_volume": 2.0}
+    ])"));
+
+    json all = car_facets(store, nullptr);
+    for (const char* field : {"year", "horsepower", "engine_volume"}) {
+        const json& histogram = all["histograms"][field];
+        EXPECT_GT(histogram["bucket"].get<double>(), 1) << field;
+        size_t total = 0;
+        for (const auto& bucket : histogram["buckets"]) total += bucket["count"].get<size_t>();
+        EXPECT_EQ(total, 3u) << field;
+        EXPECT_LE(histogram["buckets"].size(), 256u) << field;
+    }
+    EXPECT_EQ(all["histograms"]["year"]["min"], -2000000000);
+    EXPECT_EQ(all["histograms"]["engine_volume"]["max"], 1e300);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
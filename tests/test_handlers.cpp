@@ -1,12 +1,21 @@
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
 #include <fstream>
+#include <set>
 #include <string>
+#include <thread>
+#include <vector>
 #include <cstdio>
 #include <cstdlib>
 
 // Заголовки проекта
 #include "../common/json.hpp"
 #include "../server/handlers.hpp"
+#include "../server/catalog.hpp"
+#include "../server/car_snapshot.hpp"
+#include "../server/data_watcher.hpp"
 
 using json = nlohmann::json;
 
@@ -18,6 +27,7 @@ protected:
         // Создаем временную директорию data
         system("mkdir -p data");
         createTestFiles();
+        Catalog::instance().load("data");
     }
 
     void TearDown() override {
@@ -241,6 +251,497 @@ TEST_F(HandlersTest, HandlePostAdminDocumentsValid) {
     EXPECT_TRUE(result.contains("document"));
 }
 
+TEST_F(HandlersTest, AdminChangesVisibleWithoutReload) {
+    handle_delete_admin_cars(1);
+    json update = {{"price_usd", 16000}};
+    json updated = parseResponse(handle_put_admin_cars(3, update.dump()));
+    EXPECT_EQ(updated["car"]["id"], 3);
+    EXPECT_EQ(updated["car"]["price_usd"], 16000);
+
+    json cars = parseResponse(handle_get_cars());
+    ASSERT_EQ(cars.size(), 2);
+    EXPECT_EQ(cars[0]["id"], 2);
+
+    // Изменения пишутся в журнал, а не перезаписью cars.json
+    std::ifstream file("data/cars.json");
+    EXPECT_EQ(json::parse(file).size(), 3);
+    EXPECT_EQ(WriteAheadLog::read("data/catalog.wal").size(), 2u);
+
+    // При загрузке журнал применяется и переносится в бинарный снимок
+    Catalog::instance().load("data");
+    cars = parseResponse(handle_get_cars());
+    ASSERT_EQ(cars.size(), 2);
+    EXPECT_EQ(cars[1]["price_usd"], 16000);
+    auto checkpoint = CarSnapshot::read("data/cars.snapshot");
+    ASSERT_TRUE(checkpoint.has_value());
+    EXPECT_EQ(checkpoint->size(), 2u);
+    EXPECT_TRUE(WriteAheadLog::read("data/catalog.wal").empty());
+}
+
+TEST_F(HandlersTest, StartsFromSnapshotUnlessCarsJsonIsNewer) {
+    handle_delete_admin_cars(1);
+    Catalog::instance().checkpoint();
+
+    // Снимок новее cars.json: используется он, а не исходный файл
+    Catalog::instance().load("data");
+    EXPECT_EQ(Catalog::instance().snapshot()->cars->size(), 2u);
+    EXPECT_TRUE(Catalog::instance().snapshot()->cars->prices().values.mapped());
+
+    // Исправленный вручную cars.json импортируется заново
+    std::filesystem::last_write_time("data/cars.snapshot",
+        std::filesystem::last_write_time("data/cars.json") - std::chrono::seconds(10));
+    Catalog::instance().load("data");
+    EXPECT_EQ(Catalog::instance().snapshot()->cars->size(), 3u);
+    // и сразу отображается из нового снимка
+    EXPECT_TRUE(Catalog::instance().snapshot()->cars->prices().values.mapped());
+
+    // Испорченный снимок не мешает старту: автомобили берутся из cars.json
+    std::ofstream("data/cars.snapshot", std::ios::trunc) << "garbage";
+    std::filesystem::last_write_time("data/cars.json",
+        std::filesystem::last_write_time("data/cars.snapshot") - std::chrono::seconds(10));
+    Catalog::instance().load("data");
+    EXPECT_EQ(Catalog::instance().snapshot()->cars->size(), 3u);
+    EXPECT_TRUE(CarSnapshot::read("data/cars.snapshot").has_value());
+}
+
+TEST_F(HandlersTest, CheckpointServesCarsFromWrittenSnapshot) {
+    json update = {{"price_usd", 16000}};
+    handle_put_admin_cars(3, update.dump());
+    auto edited = Catalog::instance().snapshot();
+    EXPECT_FALSE(edited->cars->prices().values.mapped());
+
+    // После контрольной точки столбцы снова отображены из файла, без перезагрузки
+    Catalog::instance().checkpoint();
+    auto checkpointed = Catalog::instance().snapshot();
+    EXPECT_TRUE(checkpointed->cars->prices().values.mapped());
+    EXPECT_EQ(checkpointed->cars_version, edited->cars_version);
+    EXPECT_EQ(checkpointed->cars->to_json(), edited->cars->to_json());
+}
+
+TEST_F(HandlersTest, JournalReplaysCitiesAndDocuments) {
+    json new_city = {{"name", "Омск"}, {"delivery_days", 40}, {"delivery_cost", 1400}};
+    handle_post_admin_cities(new_city.dump());
+    handle_delete_admin_cities(1);
+    handle_put_admin_cities(3, R"({"delivery_days": 41})");
+    handle_delete_admin_documents(R"({"id": 2})");
+
+    Catalog::instance().load("data");
+    json cities = parseResponse(handle_get_cities());
+    ASSERT_EQ(cities.size(), 2);
+    EXPECT_EQ(cities[0]["name"], "Санкт-Петербург");
+    EXPECT_EQ(cities[1]["delivery_days"], 41);
+    EXPECT_EQ(parseResponse(handle_get_documents())["documents"].size(), 1);
+}
+
+TEST_F(HandlersTest, ReloadSwapsInHandEditedFile) {
+    auto before = Catalog::instance().snapshot();
+    // Файл, совпадающий с загруженным, не перечитывается
+    EXPECT_FALSE(Catalog::instance().reload(Dataset::Cities));
+
+    // Изменение из журнала уступает исправленному вручную файлу
+    handle_put_admin_cities(1, R"({"delivery_days": 31})");
+    std::ofstream("data/cities.json", std::ios::trunc) << R"([{"id": 7, "name": "Казань", "delivery_days": 33}])";
+    ASSERT_TRUE(Catalog::instance().reload(Dataset::Cities));
+
+    auto after = Catalog::instance().snapshot();
+    json cities = parseResponse(handle_get_cities());
+    ASSERT_EQ(cities.size(), 1);
+    EXPECT_EQ(cities[0]["name"], "Казань");
+    EXPECT_TRUE(after->city_ids->find(7).has_value());
+    EXPECT_GT(after->version_of(Dataset::Cities), before->version_of(Dataset::Cities));
+    EXPECT_EQ(after->cars, before->cars);
+    EXPECT_TRUE(WriteAheadLog::read("data/catalog.wal").empty());
+    Catalog::instance().load("data");
+    EXPECT_EQ(parseResponse(handle_get_cities()), cities);
+}
+
+TEST_F(HandlersTest, ReloadYieldsToCheckpointDuringParse) {
+    std::ofstream("data/cities.json", std::ios::trunc) << R"([{"id": 7, "name": "Казань"}])";
+    auto prepared = Catalog::instance().prepare_reload(Dataset::Cities);
+    ASSERT_TRUE(prepared.has_value());
+
+    // Пока файл разбирался: контрольная точка переписала его, а следующее
+    // изменение успело попасть только в журнал
+    handle_put_admin_cities(1, R"({"delivery_days": 31})");
+    Catalog::instance().checkpoint();
+    handle_put_admin_cities(2, R"({"delivery_days": 36})");
+
+    EXPECT_FALSE(Catalog::instance().apply_reload(*prepared));
+    json cities = parseResponse(handle_get_cities());
+    ASSERT_EQ(cities.size(), 2);
+    EXPECT_EQ(cities[0]["delivery_days"], 31);
+    EXPECT_EQ(cities[1]["delivery_days"], 36);
+    EXPECT_EQ(WriteAheadLog::read("data/catalog.wal").size(), 1u);
+    // Файл контрольной точки совпадает с тем, что каталог записал сам
+    EXPECT_FALSE(Catalog::instance().reload(Dataset::Cities));
+    EXPECT_EQ(parseResponse(handle_get_cities())[1]["delivery_days"], 36);
+}
+
+TEST_F(HandlersTest, ReloadKeepsDataWhenFileIsInvalid) {
+    auto before = Catalog::instance().snapshot();
+    const char* broken[] = {
+        R"([{"id": 1, "name": "Москва")",
+        R"({"id": 1})",
+        R"([{"id": 1}, {"id": 1}])",
+        R"([{"id": "1"}])",
+        R"([1, 2])"
+    };
+    for (const char* content : broken) {
+        std::ofstream("data/cities.json", std::ios::trunc) << content;
+        EXPECT_FALSE(Catalog::instance().reload(Dataset::Cities)) << content;
+    }
+    std::ofstream("data/documents.json", std::ios::trunc) << R"([{"id": 1}])";
+    EXPECT_FALSE(Catalog::instance().reload(Dataset::Documents));
+    EXPECT_EQ(Catalog::instance().snapshot()->version, before->version);
+    EXPECT_THROW(Catalog::instance().reload(Dataset::Cars), std::logic_error);
+}
+
+TEST_F(HandlersTest, WatcherReloadsEditedFiles) {
+    DataWatcher watcher("data");
+    ASSERT_TRUE(watcher.watching());
+    auto wait_for = [](auto done) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (!done() && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return done();
+    };
+
+    // Собственная контрольная точка каталога не вызывает перезагрузку
+    handle_delete_admin_cities(2);
+    Catalog::instance().checkpoint();
+    uint64_t version = Catalog::instance().snapshot()->version;
+
+    std::ofstream("data/documents.json", std::ios::trunc) << R"({"documents": [{"id": 5, "title": "ПТС"}]})";
+    EXPECT_TRUE(wait_for([] {
+        return (*Catalog::instance().snapshot()->documents)["documents"].size() == 1;
+    }));
+    // Замена файла через rename, как это делают редакторы
+    std::ofstream("data/cities.tmp") << R"([{"id": 9, "name": "Тверь"}])";
+    std::rename("data/cities.tmp", "data/cities.json");
+    EXPECT_TRUE(wait_for([] { return Catalog::instance().snapshot()->city_ids->find(9).has_value(); }));
+    EXPECT_EQ(Catalog::instance().snapshot()->version, version + 2);
+}
+
+TEST_F(HandlersTest, SnapshotUnaffectedByAdminWrites) {
+    auto before = Catalog::instance().snapshot();
+    json new_car = {{"brand", "Kia"}, {"model", "Rio"}, {"year", 2021}, {"price_usd", 9000}};
+    handle_post_admin_cars(new_car.dump());
+
+    auto after = Catalog::instance().snapshot();
+    EXPECT_EQ(before->cars->size(), 3);
+    EXPECT_EQ(after->cars->size(), 4);
+    EXPECT_GT(after->version, before->version);
+    // Неизменённые наборы данных разделяются между версиями
+    EXPECT_EQ(before->cities, after->cities);
+}
+
+TEST_F(HandlersTest, OldSnapshotFreedAfterLastReader) {
+    std::weak_ptr<const CatalogSnapshot> old = Catalog::instance().snapshot();
+    handle_get_cities();
+    json new_city = {{"name", "Омск"}, {"delivery_days", 40}, {"delivery_cost", 1400}};
+    handle_post_admin_cities(new_city.dump());
+    EXPECT_TRUE(old.expired());
+}
+
+TEST_F(HandlersTest, AdminWriteBumpsOnlyItsDatasetVersion) {
+    auto before = Catalog::instance().snapshot();
+    json new_city = {{"name", "Омск"}, {"delivery_days", 40}, {"delivery_cost", 1400}};
+    handle_post_admin_cities(new_city.dump());
+
+    auto after = Catalog::instance().snapshot();
+    EXPECT_GT(after->version_of(Dataset::Cities), before->version_of(Dataset::Cities));
+    EXPECT_EQ(after->version_of(Dataset::Cars), before->version_of(Dataset::Cars));
+    EXPECT_EQ(after->version_of(Dataset::Documents), before->version_of(Dataset::Documents));
+}
+
+TEST_F(HandlersTest, SearchUsesIndexAfterAdminChanges) {
+    json update = {{"brand", "Toyota"}};
+    handle_put_admin_cars(3, update.dump());
+    handle_delete_admin_cars(2);
+
+    json request = {{"filters", {{"brand", "Toyota"}, {"country", "Japan"}, {"year", {{"$lte", 2019}}}}}};
+    json result = parseResponse(handle_post_search(request.dump()));
+    ASSERT_EQ(result["found"], 1);
+    EXPECT_EQ(result["results"][0]["id"], 3);
+
+    json by_query = parseResponse(handle_get_search("brand=Toyota"));
+    EXPECT_EQ(by_query["found"], 2);
+}
+
+TEST_F(HandlersTest, RangeSearchMatchesLinearSemantics) {
+    json request = {{"filters", {{"price_usd", {{"$lte", 20000}}}, {"year", {{"$gte", 2017}}}}}};
+    json result = parseResponse(handle_post_search(request.dump()));
+    ASSERT_EQ(result["found"], 1);
+    EXPECT_EQ(result["results"][0]["id"], 3);
+
+    json mixed = {{"filters", {{"country", "Japan"}, {"horsepower", {{"$gte", 150}, {"$lte", 210}}}}}};
+    result = parseResponse(handle_post_search(mixed.dump()));
+    EXPECT_EQ(result["found"], 2);
+}
+
+TEST_F(HandlersTest, SearchSupportsComparisonOperators) {
+    json request = {{"filters", {{"year", {{"$gt", 2017}}}, {"brand", {{"$in", {"Toyota", "Honda"}}}}}}};
+    json result = parseResponse(handle_post_search(request.dump()));
+    ASSERT_FALSE(result.contains("error"));
+    for (const auto& car : result["results"]) {
+        EXPECT_GT(car["year"], 2017);
+        EXPECT_TRUE(car["brand"] == "Toyota" || car["brand"] == "Honda");
+    }
+
+    json unknown = {{"filters", {{"year", {{"$gtee", 2017}}}}}};
+    result = parseResponse(handle_post_search(unknown.dump()));
+    EXPECT_TRUE(result.contains("error"));
+}
+
+TEST_F(HandlersTest, SearchPagesWithCursor) {
+    json all = parseResponse(handle_post_search(json({{"filters", json::object()}, {"sort", "-price_usd"}}).dump()));
+    ASSERT_FALSE(all.contains("error"));
+    ASSERT_FALSE(all.contains("next_cursor"));
+    for (size_t i = 1; i < all["results"].size(); ++i) {
+        EXPECT_GE(all["results"][i - 1]["price_usd"], all["results"][i]["price_usd"]);
+    }
+
+    // Страницы по 2 через курсор дают тот же порядок
+    json request = {{"filters", json::object()}, {"sort", "-price_usd"}, {"limit", 2}};
+    json collected = json::array();
+    for (int pages = 0; pages < 10; ++pages) {
+        json page = parseResponse(handle_post_search(request.dump()));
+        EXPECT_EQ(page["found"], all["found"]);
+        ASSERT_LE(page["results"].size(), 2u);
+        for (const auto& car : page["results"]) collected.push_back(car);
+        if (!page.contains("next_cursor")) break;
+        request["cursor"] = page["next_cursor"];
+    }
+    EXPECT_EQ(collected, all["results"]);
+
+    json by_query = parseResponse(handle_get_search("sort=price_usd&limit=1&offset=1"));
+    ASSERT_EQ(by_query["results"].size(), 1u);
+    EXPECT_EQ(by_query["results"][0], all["results"][all["results"].size() - 2]);
+
+    json count_only = parseResponse(handle_post_search(json({{"filters", {{"brand", "Toyota"}}}, {"limit", 0}}).dump()));
+    EXPECT_TRUE(count_only["results"].empty());
+    EXPECT_GT(count_only["found"], 0);
+
+    json wrong = parseResponse(handle_get_search("sort=brand"));
+    EXPECT_TRUE(wrong.contains("error"));
+}
+
+TEST_F(HandlersTest, RejectsMalformedCursors) {
+    auto hex = [](const std::string& text) {
+        static const char HEX[] = "0123456789abcdef";
+        std::string cursor;
+        for (unsigned char c : text) {
+            cursor += HEX[c >> 4];
+            cursor += HEX[c & 0xF];
+        }
+        return cursor;
+    };
+    for (const char* text : {"price_usd;15000;1x", "price_usd;15000;99999999999", "price_usd;1e999;1",
+                             "price_usd;nan;1", "price_usd;15000x;1", "price_usd;;1", "price_usd;15000;"}) {
+        json request = {{"filters", json::object()}, {"sort", "price_usd"}, {"limit", 1}, {"cursor", hex(text)}};
+        json result = parseResponse(handle_post_search(request.dump()));
+        EXPECT_EQ(result["error"], "Invalid cursor") << text;
+    }
+}
+
+TEST_F(HandlersTest, ProjectsRequestedFields) {
+    json all = parseResponse(handle_get_cars());
+    json projected = parseResponse(handle_get_cars("fields=id,brand,price_usd"));
+    ASSERT_EQ(projected.size(), all.size());
+    for (size_t i = 0; i < all.size(); ++i) {
+        json expected = {{"id", all[i]["id"]}, {"brand", all[i]["brand"]}, {"price_usd", all[i]["price_usd"]}};
+        EXPECT_EQ(projected[i], expected);
+    }
+
+    json by_query = parseResponse(handle_get_search("brand=Toyota&fields=id,model"));
+    ASSERT_GT(by_query["found"], 0);
+    for (const auto& car : by_query["results"]) {
+        EXPECT_EQ(car.size(), 2u);
+        EXPECT_TRUE(car.contains("id") && car.contains("model"));
+    }
+
+    json request = {{"filters", {{"brand", "Toyota"}}}, {"fields", {"year"}}};
+    json result = parseResponse(handle_post_search(request.dump()));
+    EXPECT_EQ(result["found"], by_query["found"]);
+    for (const auto& car : result["results"]) {
+        EXPECT_EQ(car.size(), 1u);
+        EXPECT_TRUE(car.contains("year"));
+    }
+
+    request["fields"] = 5;
+    EXPECT_TRUE(parseResponse(handle_post_search(request.dump())).contains("error"));
+}
+
+TEST_F(HandlersTest, FacetsFollowSearchFilters) {
+    json all = parseResponse(handle_get_car_facets());
+    json cars = parseResponse(handle_get_cars());
+    EXPECT_EQ(all["found"], cars.size());
+    size_t toyota = 0;
+    for (const auto& car : cars) toyota += car.value("brand", "") == "Toyota";
+    EXPECT_EQ(all["values"]["brand"]["Toyota"], toyota);
+
+    json by_query = parseResponse(handle_get_car_facets("brand=Toyota"));
+    EXPECT_EQ(by_query["found"], toyota);
+    EXPECT_EQ(by_query["values"]["brand"], json({{"Toyota", toyota}}));
+
+    json request = {{"filters", {{"brand", "Toyota"}}}};
+    EXPECT_EQ(parseResponse(handle_post_car_facets(request.dump())), by_query);
+
+    json wrong = {{"filters", {{"year", {{"$gtee", 1}}}}}};
+    EXPECT_TRUE(parseResponse(handle_post_car_facets(wrong.dump())).contains("error"));
+}
+
+TEST_F(HandlersTest, GetSearchDecodesQueryAndIgnoresCase) {
+    json car = {{"brand", "Toyota"}, {"model", "Land Cruiser Prado"}, {"year", 2021}, {"price_usd", 52000}};
+    handle_post_admin_cars(car.dump());
+
+    json found = parseResponse(handle_get_search("brand=toyota&model=Land%20Cruiser+PRADO"));
+    ASSERT_EQ(found["found"], 1);
+    EXPECT_EQ(found["results"][0]["model"], "Land Cruiser Prado");
+    EXPECT_EQ(parseResponse(handle_get_search("brand=TOYOTA"))["found"], 2);
+    EXPECT_EQ(parseResponse(handle_get_search("brand=toyot"))["found"], 0);
+}
+
+TEST_F(HandlersTest, SuggestsPrefixesAndTypos) {
+    json prefix = parseResponse(handle_get_car_suggest("q=to"));
+    EXPECT_EQ(prefix["query"], "to");
+    ASSERT_EQ(prefix["suggestions"].size(), 1u);
+    EXPECT_EQ(prefix["suggestions"][0], json({{"field", "brand"}, {"value", "Toyota"}, {"count", 1}}));
+
+    json typo = parseResponse(handle_get_car_suggest("q=Hodna&field=brand"));
+    ASSERT_EQ(typo["suggestions"].size(), 1u);
+    EXPECT_EQ(typo["suggestions"][0]["value"], "Honda");
+
+    // Число автомобилей считается внутри фильтров
+    json filtered = parseResponse(handle_get_car_suggest("q=a&field=model&country=japan"));
+    ASSERT_EQ(filtered["suggestions"].size(), 1u);
+    EXPECT_EQ(filtered["suggestions"][0]["value"], "Accord");
+
+    EXPECT_TRUE(parseResponse(handle_get_car_suggest("field=brand")).contains("error"));
+    EXPECT_TRUE(parseResponse(handle_get_car_suggest("q=a&field=year")).contains("error"));
+}
+
+TEST_F(HandlersTest, SuggestSeesAdminChanges) {
+    json car = {{"brand", "Лада"}, {"model", "Веста"}, {"year", 2023}, {"price_usd", 14000}};
+    json added = parseResponse(handle_post_admin_cars(car.dump()));
+
+    json suggestions = parseResponse(handle_get_car_suggest("q=%D0%BB%D0%B0%D0%B4"))["suggestions"];
+    ASSERT_EQ(suggestions.size(), 1u);
+    EXPECT_EQ(suggestions[0]["value"], "Лада");
+
+    // Значение без автомобилей не предлагается
+    handle_delete_admin_cars(added["car"]["id"].get<int>());
+    EXPECT_TRUE(parseResponse(handle_get_car_suggest("q=%D0%BB%D0%B0%D0%B4"))["suggestions"].empty());
+}
+
+TEST_F(HandlersTest, FindsRecordsByIdAfterDeletes) {
+    // После удаления id перестают быть плотными, а новые id не переиспользуют удалённые
+    handle_delete_admin_cars(2);
+    handle_delete_admin_cities(1);
+    json car = parseResponse(handle_put_admin_cars(3, R"({"price_usd": 16000})"))["car"];
+    EXPECT_EQ(car["brand"], "Honda");
+    EXPECT_EQ(car["price_usd"], 16000);
+
+    json new_car = {{"brand", "Kia"}, {"model", "Rio"}, {"year", 2022}, {"price_usd", 12000}};
+    EXPECT_EQ(parseResponse(handle_post_admin_cars(new_car.dump()))["car"]["id"], 4);
+    handle_delete_admin_cars(4);
+    EXPECT_EQ(parseResponse(handle_post_admin_cars(new_car.dump()))["car"]["id"], 5);
+
+    json city = parseResponse(handle_put_admin_cities(2, R"({"delivery_days": 40})"))["city"];
+    EXPECT_EQ(city["name"], "Санкт-Петербург");
+    json new_city = {{"name", "Казань"}, {"delivery_days", 33}, {"delivery_cost", 1100}};
+    EXPECT_EQ(parseResponse(handle_post_admin_cities(new_city.dump()))["city"]["id"], 3);
+
+    json request = {{"car_id", 3}, {"city_id", 3}};
+    json delivery = parseResponse(handle_post_calculate_delivery(request.dump()));
+    EXPECT_EQ(delivery["city"]["name"], "Казань");
+    request["city_id"] = 1;
+    EXPECT_EQ(parseResponse(handle_post_calculate_delivery(request.dump()))["error"], "City not found");
+
+    handle_delete_admin_documents(R"({"id": 1})");
+    json document = {{"category", "purchase"}, {"name", "Договор"}};
+    EXPECT_EQ(parseResponse(handle_post_admin_documents(document.dump()))["document"]["id"], 3);
+    EXPECT_TRUE(parseResponse(handle_delete_admin_documents(R"({"id": 2})")).contains("status"));
+    EXPECT_TRUE(parseResponse(handle_delete_admin_documents(R"({"id": 2})")).contains("error"));
+    json documents = parseResponse(handle_get_documents())["documents"];
+    ASSERT_EQ(documents.size(), 1u);
+    EXPECT_EQ(documents[0]["name"], "Договор");
+}
+
+TEST_F(HandlersTest, ConcurrentAdminWritesAreGroupCommitted) {
+    const int THREADS = 16, WRITES = 8;
+    std::vector<std::vector<int>> ids(THREADS);
+    std::vector<std::thread> admins;
+    for (int t = 0; t < THREADS; ++t) {
+        admins.emplace_back([&, t] {
+            json car = {{"brand", "Kia"}, {"model", "Rio"}, {"year", 2020 + t % 4}, {"price_usd", 10000 + t}};
+            for (int i = 0; i < WRITES; ++i) {
+                ids[t].push_back(parseResponse(handle_post_admin_cars(car.dump()))["car"]["id"].get<int>());
+            }
+        });
+    }
+    for (auto& admin : admins) admin.join();
+
+    // Каждое изменение подтверждено после записи в журнал, id не повторяются
+    std::set<int> unique;
+    for (const auto& thread_ids : ids) {
+        // Изменения одного писателя идут в порядке отправки
+        EXPECT_TRUE(std::is_sorted(thread_ids.begin(), thread_ids.end()));
+        unique.insert(thread_ids.begin(), thread_ids.end());
+    }
+    EXPECT_EQ(unique.size(), static_cast<size_t>(THREADS * WRITES));
+    EXPECT_EQ(Catalog::instance().snapshot()->cars->size(), 3u + THREADS * WRITES);
+
+    auto journal = WriteAheadLog::read("data/catalog.wal");
+    ASSERT_EQ(journal.size(), static_cast<size_t>(THREADS * WRITES));
+    for (size_t i = 1; i < journal.size(); ++i) {
+        EXPECT_LT(journal[i - 1]["id"], journal[i]["id"]);
+    }
+}
+
+TEST_F(HandlersTest, BulkImportsNdjsonInOneBatch) {
+    std::string body =
+        "{\"brand\": \"Kia\", \"model\": \"Rio\", \"year\": 2021, \"price_usd\": 9000}\n"
+        "{\"id\": 1, \"price_usd\": 24000}\r\n"
+        "\n"
+        "{\"brand\": \"Kia\"\n"
+        "{\"id\": 50, \"brand\": \"Lada\", \"model\": \"Vesta\", \"year\": 2023, \"price_usd\": 14000}\n"
+        "{\"model\": \"Ceed\"}\n"
+        "{\"id\": \"7\"}\n"
+        "{\"id\": 4294967297, \"brand\": \"Lada\", \"model\": \"Niva\", \"year\": 2022, \"price_usd\": 12000}\n"
+        "{\"id\": -3000000000, \"price_usd\": 1}";
+    auto before = Catalog::instance().snapshot();
+    json response = parseResponse(handle_post_admin_cars_bulk(body));
+    EXPECT_EQ(response["created"], 2);
+    EXPECT_EQ(response["updated"], 1);
+    EXPECT_EQ(response["failed"], 5);
+
+    json results = response["results"];
+    ASSERT_EQ(results.size(), 8u);
+    EXPECT_EQ(results[0], json({{"line", 1}, {"status", "created"}, {"id", 4}}));
+    EXPECT_EQ(results[1], json({{"line", 2}, {"status", "updated"}, {"id", 1}}));
+    EXPECT_EQ(results[2]["line"], 4);
+    EXPECT_EQ(results[2]["status"], "error");
+    EXPECT_EQ(results[3], json({{"line", 5}, {"status", "created"}, {"id", 50}}));
+    EXPECT_EQ(results[4]["status"], "error");
+    EXPECT_EQ(results[5]["error"], "id must be a 32-bit integer");
+    // id вне int32 отклоняется, а не обрезается до существующего id 1
+    EXPECT_EQ(results[6], json({{"line", 8}, {"status", "error"}, {"error", "id must be a 32-bit integer"}}));
+    EXPECT_EQ(results[7]["error"], "id must be a 32-bit integer");
+
+    // Все строки опубликованы одной версией и одной записью журнала
+    auto after = Catalog::instance().snapshot();
+    EXPECT_EQ(after->version, before->version + 1);
+    EXPECT_EQ(after->cars->size(), 5u);
+    EXPECT_EQ(WriteAheadLog::read("data/catalog.wal").size(), 3u);
+
+    EXPECT_EQ(parseResponse(handle_get_search("brand=lada"))["found"], 1);
+    json toyota = parseResponse(handle_get_search("brand=Toyota"))["results"][0];
+    EXPECT_EQ(toyota["price_usd"], 24000);
+    EXPECT_EQ(toyota["model"], "Camry");
+}
+
 // ==================== ГЛАВНАЯ ФУНКЦИЯ ====================
 
 int main(int argc, char **argv) {
@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+#include <string>
+#include "../server/http_parser.hpp"
+
+// Разбор запроса, полученного целиком
+TEST(HttpParserTest, ParsesCompleteRequest) {
+    std::string raw =
+        "POST /search?limit=5 HTTP/1.1\r\n"
+        "Host: localhost\r\n"
+        "content-length: 13\r\n"
+        "\r\n"
+        "{\"filters\":1}";
+
+    HttpParser parser;
+    ASSERT_EQ(parser.parse(raw.data(), raw.size()), HttpParser::Result::Complete);
+    const HttpRequest& request = parser.request();
+    EXPECT_EQ(request.method, "POST");
+    EXPECT_EQ(request.path, "/search");
+    EXPECT_EQ(request.query, "limit=5");
+    EXPECT_EQ(request.header("Content-Length"), "13");
+    EXPECT_EQ(request.body, "{\"filters\":1}");
+    EXPECT_TRUE(request.keep_alive);
+    EXPECT_EQ(parser.consumed(), raw.size());
+
+    // Тело — представление в исходный буфер, без копирования
+    EXPECT_EQ(request.body.data(), raw.data() + raw.size() - 13);
+}
+
+// Данные приходят по одному байту
+TEST(HttpParserTest, ParsesIncrementally) {
+    std::string raw =
+        "PUT /admin/cars/7 HTTP/1.1\r\n"
+        "Content-Length: 2\r\n"
+        "Connection: close\r\n"
+        "\r\n"
+        "{}";
+
+    HttpParser parser;
+    for (size_t i = 1; i < raw.size(); ++i) {
+        ASSERT_EQ(parser.parse(raw.data(), i), HttpParser::Result::Incomplete) << "at " << i;
+    }
+    ASSERT_EQ(parser.parse(raw.data(), raw.size()), HttpParser::Result::Complete);
+    EXPECT_EQ(parser.request().path, "/admin/cars/7");
+    EXPECT_EQ(parser.request().body, "{}");
+    EXPECT_FALSE(parser.request().keep_alive);
+}
+
+// Конвейерные запросы: разбирается только первый
+TEST(HttpParserTest, LeavesPipelinedRequestInBuffer) {
+    std::string first = "GET /cars HTTP/1.1\r\n\r\n";
+    std::string raw = first + "GET /cities HTTP/1.1\r\n\r\n";
+
+    HttpParser parser;
+    ASSERT_EQ(parser.parse(raw.data(), raw.size()), HttpParser::Result::Complete);
+    EXPECT_EQ(parser.request().path, "/cars");
+    EXPECT_EQ(parser.consumed(), first.size());
+
+    std::string rest = raw.substr(parser.consumed());
+    parser.reset();
+    ASSERT_EQ(parser.parse(rest.data(), rest.size()), HttpParser::Result::Complete);
+    EXPECT_EQ(parser.request().path, "/cities");
+}
+
+TEST(HttpParserTest, DecodesChunkedBody) {
+    std::string raw =
+        "POST /search HTTP/1.1\r\n"
+        "Transfer-Encoding: chunked\r\n"
+        "\r\n"
+        "4\r\n{\"fi\r\n"
+        "a;ext=1\r\nlters\":{}}\r\n"
+        "0\r\n"
+        "\r\n";
+
+    HttpParser parser;
+    ASSERT_EQ(parser.parse(raw.data(), raw.size()), HttpParser::Result::Complete);
+    EXPECT_EQ(parser.request().body, "{\"filters\":{}}");
+    EXPECT_EQ(parser.consumed(), raw.size());
+}
+
+TEST(HttpParserTest, RejectsEndlessTrailers) {
+    std::string raw =
+        "POST /search HTTP/1.1\r\n"
+        "Transfer-Encoding: chunked\r\n"
+        "\r\n"
+        "0\r\n";
+    while (raw.size() < 2 * HttpParser::MAX_HEADER_SIZE) raw += "X-Trailer: value\r\n";
+
+    HttpParser parser;
+    EXPECT_EQ(parser.parse(raw.data(), raw.size()), HttpParser::Result::Error);
+    EXPECT_EQ(parser.error_status(), 431);
+}
+
+TEST(HttpParserTest, LimitsChunkFramingOverhead) {
+    // Однобайтовые чанки: тело укладывается в MAX_BODY_SIZE, а запрос целиком — нет
+    std::string raw =
+        "POST /search HTTP/1.1\r\n"
+        "Transfer-Encoding: chunked\r\n"
+        "\r\n";
+    while (raw.size() <= HttpParser::MAX_REQUEST_SIZE) raw += "1\r\nx\r\n";
+
+    HttpParser parser;
+    EXPECT_EQ(parser.parse(raw.data(), raw.size()), HttpParser::Result::Error);
+    EXPECT_EQ(parser.error_status(), 413);
+}
+
+TEST(HttpParserTest, Http10DefaultsToClose) {
+    std::string raw = "GET /cars HTTP/1.0\r\n\r\n";
+    HttpParser parser;
+    ASSERT_EQ(parser.parse(raw.data(), raw.size()), HttpParser::Result::Complete);
+    EXPECT_FALSE(parser.request().keep_alive);
+}
+
+TEST(HttpParserTest, RejectsInvalidContentLength) {
+    std::string raw =
+        "POST /search HTTP/1.1\r\n"
+        "Content-Length: abc\r\n"
+        "\r\n";
+
+    HttpParser parser;
+    EXPECT_EQ(parser.parse(raw.data(), raw.size()), HttpParser::Result::Error);
+    EXPECT_EQ(parser.error_status(), 400);
+}
+
+TEST(HttpParserTest, RejectsMalformedRequestLine) {
+    std::string raw = "GARBAGE\r\n\r\n";
+    HttpParser parser;
+    EXPECT_EQ(parser.parse(raw.data(), raw.size()), HttpParser::Result::Error);
+    EXPECT_EQ(parser.error_status(), 400);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+#include <map>
+#include <random>
+#include "../server/id_index.hpp"
+
+TEST(IdIndexTest, FindsInsertedIds) {
+    IdIndex index;
+    EXPECT_FALSE(index.find(1).has_value());
+    EXPECT_TRUE(index.insert(10, 0));
+    EXPECT_TRUE(index.insert(-3, 1));
+    EXPECT_FALSE(index.insert(10, 2)); // повторный id
+    EXPECT_EQ(index.find(10), 0u);
+    EXPECT_EQ(index.find(-3), 1u);
+    EXPECT_FALSE(index.find(11).has_value());
+    EXPECT_EQ(index.size(), 2u);
+}
+
+TEST(IdIndexTest, AllocatesMonotonicIds) {
+    IdIndex index;
+    EXPECT_EQ(index.allocate(), 1);
+    index.insert(1, 0);
+    index.insert(7, 1);
+    EXPECT_EQ(index.next_id(), 8);
+    index.erase(7);
+    EXPECT_EQ(index.allocate(), 8);
+    EXPECT_EQ(index.allocate(), 9);
+}
+
+TEST(IdIndexTest, ShiftsSlotsAfterRemoval) {
+    IdIndex index;
+    for (int32_t id = 1; id <= 5; ++id) index.insert(id * 100, static_cast<uint32_t>(id - 1));
+    index.erase(200);
+    index.shift_after(1);
+    EXPECT_EQ(index.find(100), 0u);
+    EXPECT_EQ(index.find(300), 1u);
+    EXPECT_EQ(index.find(500), 3u);
+}
+
+// Случайные вставки и удаления против std::map: обратный сдвиг не теряет записи
+TEST(IdIndexTest, MatchesMapUnderChurn) {
+    std::mt19937 rng(42);
+    IdIndex index;
+    std::map<int32_t, uint32_t> expected;
+    for (int step = 0; step < 20000; ++step) {
+        int32_t id = static_cast<int32_t>(rng() % 2000);
+        if (rng() % 3 == 0) {
+            EXPECT_EQ(index.erase(id), expected.erase(id) == 1);
+        }
+        else {
+            uint32_t slot = rng() % 1000;
+            EXPECT_EQ(index.insert(id, slot), expected.emplace(id, slot).second);
+        }
+    }
+    EXPECT_EQ(index.size(), expected.size());
+    for (int32_t id = 0; id < 2000; ++id) {
+        auto it = expected.find(id);
+        auto found = index.find(id);
+        ASSERT_EQ(found.has_value(), it != expected.end());
+        if (found) {
+            EXPECT_EQ(*found, it->second);
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include <set>
+#include <vector>
+#include "../server/roaring.hpp"
+
+// Случайное множество: плотная часть (станет битовым блоком) и разреженная
+std::set<uint32_t> randomSet(uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::set<uint32_t> values;
+    for (int i = 0; i < 6000; ++i) values.insert(rng() % 65536);
+    for (int i = 0; i < 300; ++i) values.insert(65536 + rng() % 500000);
+    return values;
+}
+
+RoaringBitmap fromSet(const std::set<uint32_t>& values) {
+    return RoaringBitmap::from_sorted(std::vector<uint32_t>(values.begin(), values.end()));
+}
+
+TEST(RoaringBitmapTest, AddRemoveContains) {
+    RoaringBitmap bitmap;
+    bitmap.add(5);
+    bitmap.add(70000);
+    bitmap.add(5);
+    EXPECT_EQ(bitmap.cardinality(), 2u);
+    EXPECT_TRUE(bitmap.contains(70000));
+    EXPECT_FALSE(bitmap.contains(6));
+    bitmap.remove(5);
+    EXPECT_EQ(bitmap.to_vector(), (std::vector<uint32_t>{70000}));
+    bitmap.remove(70000);
+    EXPECT_TRUE(bitmap.empty());
+}
+
+TEST(RoaringBitmapTest, AndOrMatchSetOperations) {
+    std::set<uint32_t> a = randomSet(1);
+    std::set<uint32_t> b = randomSet(2);
+    std::vector<uint32_t> expected_and;
+    std::vector<uint32_t> expected_or;
+    std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(expected_and));
+    std::set_union(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(expected_or));
+
+    RoaringBitmap ra = fromSet(a);
+    RoaringBitmap rb = fromSet(b);
+    EXPECT_EQ(ra.cardinality(), a.size());
+    EXPECT_EQ((ra & rb).to_vector(), expected_and);
+    EXPECT_EQ((ra | rb).to_vector(), expected_or);
+    EXPECT_EQ(RoaringBitmap::and_cardinality(ra, rb), expected_and.size());
+}
+
+TEST(RoaringBitmapTest, DenseBlockShrinksBackToArray) {
+    RoaringBitmap bitmap;
+    for (uint32_t i = 0; i < 5000; ++i) bitmap.add(i);
+    for (uint32_t i = 0; i < 4990; ++i) bitmap.remove(i);
+    EXPECT_EQ(bitmap.cardinality(), 10u);
+    EXPECT_TRUE(bitmap.contains(4999));
+}
+
+TEST(RoaringBitmapTest, RemoveAndShift) {
+    RoaringBitmap bitmap = RoaringBitmap::from_sorted({1, 3, 65536, 65540});
+    bitmap.remove_and_shift(3);
+    EXPECT_EQ(bitmap.to_vector(), (std::vector<uint32_t>{1, 65535, 65539}));
+    bitmap.remove_and_shift(2);
+    EXPECT_EQ(bitmap.to_vector(), (std::vector<uint32_t>{1, 65534, 65538}));
+    bitmap.remove_and_shift(100000);
+    EXPECT_EQ(bitmap.cardinality(), 3u);
+}
+
+TEST(RoaringBitmapTest, RemoveAndShiftMatchesSortedVector) {
+    for (uint32_t seed = 1; seed <= 4; ++seed) {
+        std::set<uint32_t> values = randomSet(seed);
+        // Значения на границах блоков: перенос младшего значения в предыдущий блок
+        values.insert({65535, 65536, 131072, 196608, 196609});
+        RoaringBitmap bitmap = fromSet(values);
+        std::vector<uint32_t> expected(values.begin(), values.end());
+
+        std::mt19937 rng(seed);
+        for (int step = 0; step < 200; ++step) {
+            uint32_t row;
+            if (step % 3 == 0) row = expected[rng() % expected.size()];
+            else if (step % 3 == 1) row = (rng() % 4) << 16; // начало блока
+            else row = rng() % 600000;
+            auto it = std::lower_bound(expected.begin(), expected.end(), row);
+            if (it != expected.end() && *it == row) it = expected.erase(it);
+            for (; it != expected.end(); ++it) --*it;
+            bitmap.remove_and_shift(row);
+        }
+        EXPECT_EQ(bitmap.to_vector(), expected);
+        EXPECT_EQ(bitmap.cardinality(), expected.size());
+    }
+}
+
+TEST(RoaringBitmapTest, RemoveAndShiftCarriesIntoMissingBlock) {
+    RoaringBitmap bitmap = RoaringBitmap::from_sorted({5, 131072, 131073});
+    bitmap.remove_and_shift(70000);
+    EXPECT_EQ(bitmap.to_vector(), (std::vector<uint32_t>{5, 131071, 131072}));
+    EXPECT_TRUE(bitmap.contains(131071));
+    bitmap.remove_and_shift(5);
+    bitmap.remove_and_shift(0);
+    EXPECT_EQ(bitmap.to_vector(), (std::vector<uint32_t>{131069, 131070}));
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
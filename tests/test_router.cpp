@@ -0,0 +1,130 @@
+#include <gtest/gtest.h>
+#include <string>
+#include "../server/router.hpp"
+#include "../server/response_cache.hpp"
+
+// Вспомогательная функция: запрос с заданным методом и путём
+HttpRequest makeRequest(std::string_view method, std::string_view path) {
+    HttpRequest request;
+    request.method = method;
+    request.path = path;
+    return request;
+}
+
+class RouterTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        router.add("GET", "/cars", [](const HttpRequest&, const RouteParams&) {
+            return HttpResponse::ok("list");
+        });
+        router.add("POST", "/admin/cars", [](const HttpRequest&, const RouteParams&) {
+            return HttpResponse::ok("add");
+        });
+        router.add("PUT", "/admin/cars/{id:int}", [](const HttpRequest&, const RouteParams& params) {
+            return HttpResponse::ok("update " + std::to_string(params.get_int("id")));
+        }, true);
+        router.add("GET", "/admin/cars/export", [](const HttpRequest&, const RouteParams&) {
+            return HttpResponse::ok("export");
+        });
+    }
+
+    Router router;
+};
+
+TEST_F(RouterTest, MatchesStaticRoute) {
+    HttpResponse response = router.dispatch(makeRequest("GET", "/cars"));
+    EXPECT_EQ(response.status, 200);
+    EXPECT_EQ(response.body, "list");
+}
+
+TEST_F(RouterTest, ExtractsIntParameter) {
+    HttpResponse response = router.dispatch(makeRequest("PUT", "/admin/cars/42"));
+    EXPECT_EQ(response.status, 200);
+    EXPECT_EQ(response.body, "update 42");
+}
+
+TEST_F(RouterTest, StaticSegmentWinsOverParameter) {
+    HttpResponse response = router.dispatch(makeRequest("GET", "/admin/cars/export"));
+    EXPECT_EQ(response.body, "export");
+}
+
+TEST_F(RouterTest, MalformedIntParameterIsBadRequest) {
+    EXPECT_EQ(router.dispatch(makeRequest("PUT", "/admin/cars/abc")).status, 400);
+    EXPECT_EQ(router.dispatch(makeRequest("PUT", "/admin/cars/99999999999")).status, 400);
+}
+
+TEST_F(RouterTest, UnknownPathAndMethod) {
+    EXPECT_EQ(router.dispatch(makeRequest("GET", "/unknown")).status, 404);
+    EXPECT_EQ(router.dispatch(makeRequest("DELETE", "/cars")).status, 405);
+}
+
+TEST_F(RouterTest, RejectsDuplicateRoute) {
+    EXPECT_THROW(router.add("GET", "/cars", [](const HttpRequest&, const RouteParams&) {
+        return HttpResponse::ok("");
+    }), std::invalid_argument);
+}
+
+TEST_F(RouterTest, ReportsBlockingRoutes) {
+    EXPECT_TRUE(router.blocking(makeRequest("PUT", "/admin/cars/42")));
+    EXPECT_FALSE(router.blocking(makeRequest("GET", "/admin/cars/export")));
+    EXPECT_FALSE(router.blocking(makeRequest("GET", "/cars")));
+    EXPECT_FALSE(router.blocking(makeRequest("PUT", "/admin/cars/abc")));
+    EXPECT_FALSE(router.blocking(makeRequest("DELETE", "/admin/cars/42")));
+    EXPECT_FALSE(router.blocking(makeRequest("PUT", "/missing")));
+    // Флаг не меняет обработку
+    EXPECT_EQ(router.dispatch(makeRequest("PUT", "/admin/cars/42")).body, "update 42");
+}
+
+TEST(ETagTest, DependsOnBodyOnly) {
+    std::string etag = make_etag(R"([{"id":1}])");
+    EXPECT_EQ(etag.size(), 18u);
+    EXPECT_EQ(etag.front(), '"');
+    EXPECT_EQ(etag, make_etag(R"([{"id":1}])"));
+    EXPECT_NE(etag, make_etag(R"([{"id":2}])"));
+}
+
+TEST(ETagTest, MatchesIfNoneMatchList) {
+    std::string etag = make_etag("body");
+    EXPECT_TRUE(etag_matches(etag, etag));
+    EXPECT_TRUE(etag_matches("\"old\", " + etag, etag));
+    EXPECT_TRUE(etag_matches("W/" + etag, etag));
+    EXPECT_TRUE(etag_matches("*", etag));
+    EXPECT_FALSE(etag_matches("\"old\"", etag));
+    EXPECT_FALSE(etag_matches("", etag));
+}
+
+TEST(ETagTest, NotModifiedHasNoBody) {
+    auto response = PreparedResponse::not_modified("\"abc\"");
+    EXPECT_EQ(response->head(), "HTTP/1.1 304 Not Modified\r\nETag: \"abc\"\r\n");
+    EXPECT_TRUE(response->body().empty());
+}
+
+TEST(QueryResponseCacheTest, EvictsLeastRecentlyUsedQuery) {
+    QueryResponseCache caches(2);
+    auto fields = caches.get("fields=id");
+    auto page = caches.get("page=2");
+    EXPECT_EQ(caches.get("fields=id"), fields);
+
+    // Новая строка вытесняет ту, что дольше всех не запрашивали
+    caches.get("q=junk");
+    EXPECT_EQ(caches.size(), 2u);
+    EXPECT_EQ(caches.get("fields=id"), fields);
+    EXPECT_NE(caches.get("page=2"), page);
+}
+
+TEST(QueryResponseCacheTest, RebuildsOnlyOnVersionChange) {
+    QueryResponseCache caches(4);
+    int builds = 0;
+    auto build = [&] { ++builds; return std::string("[]"); };
+    HttpRequest request = makeRequest("GET", "/cars");
+    caches.get("fields=id")->respond(request, 1, build);
+    caches.get("fields=id")->respond(request, 1, build);
+    EXPECT_EQ(builds, 1);
+    caches.get("fields=id")->respond(request, 2, build);
+    EXPECT_EQ(builds, 2);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+#include "../server/simd_scan.hpp"
+
+// Эталонная побитовая проверка
+template<class T>
+std::vector<uint64_t> expectedRange(const std::vector<T>& values, T lo, T hi) {
+    std::vector<uint64_t> bits((values.size() + 63) / 64, 0);
+    for (size_t i = 0; i < values.size(); ++i) {
+        if (values[i] >= lo && values[i] <= hi) bits[i / 64] |= uint64_t(1) << (i % 64);
+    }
+    return bits;
+}
+
+template<class T>
+std::vector<uint64_t> actualRange(const std::vector<T>& values, T lo, T hi) {
+    std::vector<uint64_t> bits((values.size() + 63) / 64, ~uint64_t(0));
+    scan_range(values.data(), values.size(), lo, hi, bits.data());
+    return bits;
+}
+
+TEST(SimdScanTest, ReportsImplementation) {
+    std::string name = scan_implementation();
+    EXPECT_TRUE(name == "avx2" || name == "sse4.1" || name == "scalar");
+}
+
+TEST(SimdScanTest, Int32RangeMatchesScalar) {
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<int32_t> dist(-50, 50);
+    // Размеры с неполным последним словом и без него
+    for (size_t n : {0, 1, 63, 64, 65, 200, 1000}) {
+        std::vector<int32_t> values(n);
+        for (auto& v : values) v = dist(rng);
+        EXPECT_EQ(actualRange<int32_t>(values, -10, 20), expectedRange<int32_t>(values, -10, 20)) << n;
+    }
+    std::vector<int32_t> edges(130, std::numeric_limits<int32_t>::min());
+    edges[5] = std::numeric_limits<int32_t>::max();
+    EXPECT_EQ(actualRange<int32_t>(edges, std::numeric_limits<int32_t>::min(), 0),
+              expectedRange<int32_t>(edges, std::numeric_limits<int32_t>::min(), 0));
+}
+
+TEST(SimdScanTest, UInt32RangeUsesUnsignedOrder) {
+    std::vector<uint32_t> values(300);
+    for (size_t i = 0; i < values.size(); ++i) values[i] = static_cast<uint32_t>(i * 16777259u);
+    EXPECT_EQ(actualRange<uint32_t>(values, 1u << 31, 0xFFFFFFFFu), expectedRange<uint32_t>(values, 1u << 31, 0xFFFFFFFFu));
+    EXPECT_EQ(actualRange<uint32_t>(values, 5000, 2000000000u), expectedRange<uint32_t>(values, 5000, 2000000000u));
+}
+
+TEST(SimdScanTest, DoubleRangeMatchesScalar) {
+    std::vector<double> values(250);
+    for (size_t i = 0; i < values.size(); ++i) values[i] = 0.1 * static_cast<double>(i % 40);
+    EXPECT_EQ(actualRange<double>(values, 1.5, 2.5), expectedRange<double>(values, 1.5, 2.5));
+}
+
+TEST(SimdScanTest, AndPresentClearsAbsentRows) {
+    std::vector<uint8_t> present(150, 1);
+    present[0] = present[64] = present[149] = 0;
+    std::vector<uint64_t> bits(3, ~uint64_t(0));
+    scan_and_present(present.data(), present.size(), bits.data());
+    EXPECT_EQ(bits[0], ~uint64_t(1));
+    EXPECT_EQ(bits[1], ~uint64_t(1));
+    EXPECT_EQ(bits[2] & (uint64_t(1) << 21), 0u);
+    EXPECT_NE(bits[2] & (uint64_t(1) << 20), 0u);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
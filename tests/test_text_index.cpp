@@ -0,0 +1,73 @@
+#include <gtest/gtest.h>
+#include <utility>
+#include <vector>
+#include "../server/text_index.hpp"
+
+// Индекс марок как в словаре столбца: номер значения — его позиция
+TextIndex brands() {
+    TextIndex index;
+    const char* values[] = {"Toyota", "Land Cruiser Prado", "Lexus", "Лада Веста", "BMW", "Land Rover"};
+    for (uint32_t id = 0; id < 6; ++id) index.add(id, values[id]);
+    return index;
+}
+
+TEST(TextIndexTest, FoldCaseLatinAndCyrillic) {
+    EXPECT_EQ(fold_case("Land Cruiser"), "land cruiser");
+    EXPECT_EQ(fold_case("ЛАДА Ёлка"), "лада ёлка");
+    EXPECT_EQ(fold_case("Citroën ÉLYSÉE"), "citroën élysée");
+    EXPECT_EQ(fold_case("BMW X5"), "bmw x5");
+}
+
+TEST(TextIndexTest, ExactIgnoresCase) {
+    TextIndex index = brands();
+    EXPECT_EQ(index.exact("toyota"), (std::vector<uint32_t>{0}));
+    EXPECT_EQ(index.exact(fold_case("ЛАДА ВЕСТА")), (std::vector<uint32_t>{3}));
+    EXPECT_TRUE(index.exact("toyot").empty());
+    EXPECT_EQ(index.size(), 6u);
+}
+
+TEST(TextIndexTest, PrefixMatchesValueAndWordStarts) {
+    TextIndex index = brands();
+    EXPECT_EQ(index.with_prefix("l"), (std::vector<uint32_t>{1, 2, 5}));
+    EXPECT_EQ(index.with_prefix("land "), (std::vector<uint32_t>{1, 5}));
+    // "cru" — начало второго слова
+    EXPECT_EQ(index.with_prefix("cru"), (std::vector<uint32_t>{1}));
+    EXPECT_EQ(index.with_prefix(fold_case("Вес")), (std::vector<uint32_t>{3}));
+    EXPECT_TRUE(index.with_prefix("ruiser").empty());
+    EXPECT_TRUE(index.with_prefix("xyz").empty());
+}
+
+TEST(TextIndexTest, FuzzyPrefixToleratesTypos) {
+    TextIndex index = brands();
+    auto toyota = index.fuzzy_prefix("toyta", 1);
+    ASSERT_FALSE(toyota.empty());
+    EXPECT_EQ(toyota[0], (std::pair<uint32_t, int>{0, 1}));
+
+    // Переставленные буквы — одна правка
+    EXPECT_EQ(index.fuzzy_prefix("toyoat", 1)[0], (std::pair<uint32_t, int>{0, 1}));
+
+    // Опечатка в начале слова и в кириллице
+    auto cruiser = index.fuzzy_prefix("cruser", 1);
+    ASSERT_EQ(cruiser.size(), 1u);
+    EXPECT_EQ(cruiser[0].first, 1u);
+    auto lada = index.fuzzy_prefix(fold_case("Лвда"), 1);
+    ASSERT_FALSE(lada.empty());
+    EXPECT_EQ(lada[0].first, 3u);
+
+    // Точное начало — расстояние 0, а лишние правки отсекаются
+    EXPECT_EQ(index.fuzzy_prefix("lex", 1)[0], (std::pair<uint32_t, int>{2, 0}));
+    EXPECT_TRUE(index.fuzzy_prefix("mercedes", 2).empty());
+}
+
+TEST(TextIndexTest, AddsValuesIncrementally) {
+    TextIndex index = brands();
+    EXPECT_TRUE(index.with_prefix("tes").empty());
+    index.add(6, "Tesla");
+    EXPECT_EQ(index.with_prefix("tes"), (std::vector<uint32_t>{6}));
+    EXPECT_EQ(index.exact("tesla"), (std::vector<uint32_t>{6}));
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
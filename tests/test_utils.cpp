@@ -92,6 +92,42 @@ TEST(UtilsTest, ExtractJsonFromResponseEmpty) {
     EXPECT_TRUE(result.empty());
 }
 
+// Тесты для get_header_value
+TEST(UtilsTest, GetHeaderValueCaseInsensitive) {
+    std::string headers =
+        "HTTP/1.1 200 OK\r\n"
+        "content-length: 20\r\n"
+        "Connection:  keep-alive \r\n"
+        "\r\n";
+
+    EXPECT_EQ(get_header_value(headers, "Content-Length"), "20");
+    EXPECT_EQ(get_header_value(headers, "connection"), "keep-alive");
+}
+
+TEST(UtilsTest, GetHeaderValueMissing) {
+    std::string headers =
+        "GET /cars HTTP/1.1\r\n"
+        "Host: localhost\r\n"
+        "\r\n"
+        "Content-Length: 5";
+
+    EXPECT_EQ(get_header_value(headers, "Content-Length"), "");
+}
+
+TEST(UtilsTest, UrlDecodeHandlesPercentAndPlus) {
+    EXPECT_EQ(url_decode("Land%20Cruiser"), "Land Cruiser");
+    EXPECT_EQ(url_decode("Land+Cruiser"), "Land Cruiser");
+    EXPECT_EQ(url_decode("%D0%9B%D0%B0%D0%B4%D0%B0"), "Лада");
+    EXPECT_EQ(url_decode("100%"), "100%");
+    EXPECT_EQ(url_decode("%zz"), "%zz");
+}
+
+TEST(UtilsTest, UrlEncodeRoundTrips) {
+    EXPECT_EQ(url_encode("Land Cruiser"), "Land%20Cruiser");
+    EXPECT_EQ(url_encode("a&b=c"), "a%26b%3Dc");
+    EXPECT_EQ(url_decode(url_encode("Лада Веста & Co")), "Лада Веста & Co");
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+#include <csignal>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <sys/resource.h>
+#include <vector>
+#include "../server/wal.hpp"
+
+class WriteAheadLogTest : public ::testing::Test {
+protected:
+    void SetUp() override { std::remove(path.c_str()); }
+    void TearDown() override { std::remove(path.c_str()); }
+
+    const std::string path = "test_catalog.wal";
+};
+
+TEST_F(WriteAheadLogTest, AppendsAndReadsInOrder) {
+    {
+        WriteAheadLog wal(path);
+        wal.append({{{"id", 1}}, {{"id", 2}}});
+        wal.append({{{"id", 3}, {"deleted", true}}});
+        EXPECT_EQ(wal.size(), 3u);
+    }
+    // Повторное открытие дописывает в конец
+    WriteAheadLog wal(path);
+    wal.append({{{"id", 4}}});
+
+    auto entries = WriteAheadLog::read(path);
+    ASSERT_EQ(entries.size(), 4u);
+    EXPECT_EQ(entries[0]["id"], 1);
+    EXPECT_EQ(entries[2]["deleted"], true);
+    EXPECT_EQ(entries[3]["id"], 4);
+}
+
+TEST_F(WriteAheadLogTest, StopsAtTornTail) {
+    {
+        WriteAheadLog wal(path);
+        wal.append({{{"id", 1}}, {{"id", 2}}});
+    }
+    // Запись, оборванная падением посреди строки
+    std::ofstream(path, std::ios::app) << R"({"id": 3, "rec)";
+    auto entries = WriteAheadLog::read(path);
+    ASSERT_EQ(entries.size(), 2u);
+    EXPECT_EQ(entries[1]["id"], 2);
+
+    // Испорченная строка обрывает чтение, даже если за ней есть целые
+    std::ofstream(path, std::ios::app) << "\n{\"id\": 4}\n";
+    EXPECT_EQ(WriteAheadLog::read(path).size(), 2u);
+
+    // При открытии хвост отрезается, и новые записи читаются
+    WriteAheadLog wal(path);
+    wal.append({{{"id", 5}}});
+    auto reopened = WriteAheadLog::read(path);
+    ASSERT_EQ(reopened.size(), 3u);
+    EXPECT_EQ(reopened[2]["id"], 5);
+}
+
+TEST_F(WriteAheadLogTest, FailedAppendLeavesNoTrace) {
+    WriteAheadLog wal(path);
+    wal.append({{{"id", 1}}});
+
+    // Лимит размера файла обрывает запись пачки посередине
+    struct rlimit old_limit;
+    ASSERT_EQ(getrlimit(RLIMIT_FSIZE, &old_limit), 0);
+    auto old_handler = std::signal(SIGXFSZ, SIG_IGN);
+    struct rlimit limit = old_limit;
+    limit.rlim_cur = 64;
+    ASSERT_EQ(setrlimit(RLIMIT_FSIZE, &limit), 0);
+    std::vector<json> big = {{{"id", 2}, {"record", std::string(200, 'x')}}, {{"id", 3}}};
+    EXPECT_THROW(wal.append(big), std::runtime_error);
+    setrlimit(RLIMIT_FSIZE, &old_limit);
+    std::signal(SIGXFSZ, old_handler);
+    EXPECT_FALSE(wal.poisoned());
+
+    wal.append({{{"id", 4}}});
+    auto entries = WriteAheadLog::read(path);
+    ASSERT_EQ(entries.size(), 2u);
+    EXPECT_EQ(entries[0]["id"], 1);
+    EXPECT_EQ(entries[1]["id"], 4);
+    EXPECT_EQ(wal.size(), 2u);
+}
+
+TEST_F(WriteAheadLogTest, ResetEmptiesLog) {
+    WriteAheadLog wal(path);
+    wal.append({{{"id", 1}}});
+    wal.reset();
+    EXPECT_EQ(wal.size(), 0u);
+    EXPECT_TRUE(WriteAheadLog::read(path).empty());
+    wal.append({{{"id", 2}}});
+    auto entries = WriteAheadLog::read(path);
+    ASSERT_EQ(entries.size(), 1u);
+    EXPECT_EQ(entries[0]["id"], 2);
+}
+
+TEST_F(WriteAheadLogTest, WritesFileAtomically) {
+    const std::string file = "test_atomic.json";
+    ASSERT_TRUE(write_file_atomically(file, "[1]"));
+    ASSERT_TRUE(write_file_atomically(file, "[1, 2]"));
+    std::ifstream in(file);
+    std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    EXPECT_EQ(content, "[1, 2]");
+    std::ifstream tmp(file + ".tmp");
+    EXPECT_FALSE(tmp.is_open());
+    std::remove(file.c_str());
+
+    EXPECT_FALSE(write_file_atomically("no_such_dir/file.json", "[]"));
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}